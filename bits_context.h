@@ -149,6 +149,21 @@ inline bool isMapped(TReadsContext const & ctx, TReadId readId)
     return ctx.mapped[readId];
 }
 
+// ----------------------------------------------------------------------------
+// Function clearMapped()
+// ----------------------------------------------------------------------------
+// Marks all reads as unmapped, their minimum errors are kept.
+
+template <typename TSpec, typename TConfig>
+inline void clearMapped(ReadsContext<TSpec, TConfig> & ctx)
+{
+    typedef typename Size<String<bool, Packed<> > >::Type   TSize;
+
+    TSize readsCount = length(ctx.mapped);
+    clear(ctx.mapped);
+    resize(ctx.mapped, readsCount, false, Exact());
+}
+
 // ----------------------------------------------------------------------------
 // Function setPaired()
 // ----------------------------------------------------------------------------
@@ -222,7 +222,7 @@ template <typename TSpec = void>
 struct Match
 {
     unsigned        readId       : YaraBits<TSpec>::READ_ID;
-    unsigned char   contigId; // : YaraBits<TSpec>::CONTIG_ID;
+    unsigned        contigId     : YaraBits<TSpec>::CONTIG_ID;
     bool            isRev        : 1;
     unsigned        contigBegin  : YaraBits<TSpec>::CONTIG_SIZE;
     unsigned short  contigEnd    : YaraBits<TSpec>::READ_SIZE;
@@ -375,7 +375,7 @@ inline unsigned getReadId(Match<TSpec> const & me)
 }
 
 template <typename TSpec>
-inline unsigned char getContigId(Match<TSpec> const & me)
+inline unsigned getContigId(Match<TSpec> const & me)
 {
     return me.contigId;
 }
@@ -462,9 +462,9 @@ inline unsigned getCigarLength(Match<TSpec> const & me)
 template <typename TSpec>
 inline unsigned long getSortKey(Match<TSpec> const & me, SortBeginPos)
 {
-    return ((unsigned long)getContigId(me)     << (YaraBits<TSpec>::READ_ID + 1 + YaraBits<TSpec>::ERRORS)) |
-           ((unsigned long)onReverseStrand(me) << (YaraBits<TSpec>::READ_ID + YaraBits<TSpec>::ERRORS))     |
-           ((unsigned long)getContigBegin(me)  <<  YaraBits<TSpec>::ERRORS)                                 |
+    return ((unsigned long)getContigId(me)     << (YaraBits<TSpec>::CONTIG_SIZE + 1 + YaraBits<TSpec>::ERRORS)) |
+           ((unsigned long)onReverseStrand(me) << (YaraBits<TSpec>::CONTIG_SIZE + YaraBits<TSpec>::ERRORS))     |
+           ((unsigned long)getContigBegin(me)  <<  YaraBits<TSpec>::ERRORS)                                     |
            ((unsigned long)getErrors(me));
 }
 
@@ -475,9 +475,9 @@ inline unsigned long getSortKey(Match<TSpec> const & me, SortBeginPos)
 template <typename TSpec>
 inline unsigned long getSortKey(Match<TSpec> const & me, SortEndPos)
 {
-    return ((unsigned long)getContigId(me)     << (YaraBits<TSpec>::READ_ID + 1 + YaraBits<TSpec>::ERRORS)) |
-           ((unsigned long)onReverseStrand(me) << (YaraBits<TSpec>::READ_ID + YaraBits<TSpec>::ERRORS))     |
-           ((unsigned long)getContigEnd(me)    <<  YaraBits<TSpec>::ERRORS)                                 |
+    return ((unsigned long)getContigId(me)     << (YaraBits<TSpec>::CONTIG_SIZE + 1 + YaraBits<TSpec>::ERRORS)) |
+           ((unsigned long)onReverseStrand(me) << (YaraBits<TSpec>::CONTIG_SIZE + YaraBits<TSpec>::ERRORS))     |
+           ((unsigned long)getContigEnd(me)    <<  YaraBits<TSpec>::ERRORS)                                     |
            ((unsigned long)getErrors(me));
 }
 
@@ -0,0 +1,230 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the batched exact search.
+// ==========================================================================
+
+#ifndef APP_YARA_FIND_BATCHED_H_
+#define APP_YARA_FIND_BATCHED_H_
+
+using namespace seqan;
+
+// ============================================================================
+// Tags
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Tag Batched
+// ----------------------------------------------------------------------------
+
+struct Batched_;
+typedef Tag<Batched_> Batched;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class BatchedFinder
+// ----------------------------------------------------------------------------
+// Advances a batch of needles in lockstep, each LF step prefetches the rank
+// blocks of the next step while the other needles of the batch are processed.
+// One instance per thread.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate>
+struct BatchedFinder
+{
+    typedef typename Iterator<TIndex, TopDown<> >::Type     TIndexIt;
+    typedef typename Size<TIndex>::Type                     TSize;
+    typedef Pair<TSize>                                     TRange;
+    typedef typename Size<TNeedles>::Type                   TNeedleId;
+    typedef typename Value<TNeedles>::Type                  TNeedle;
+    typedef typename Size<TNeedle>::Type                    TNeedleSize;
+
+    static const unsigned BATCH = 32;
+
+    TIndex &                index;
+    TKmersTable const &     kmers;
+    TNeedles &              needles;
+    TDelegate &             delegate;
+
+    BatchedFinder(TIndex & index, TKmersTable const & kmers, TNeedles & needles, TDelegate & delegate) :
+        index(index),
+        kmers(kmers),
+        needles(needles),
+        delegate(delegate)
+    {}
+
+    template <typename TBatchesIt>
+    void operator() (TBatchesIt const & batchesIt)
+    {
+        _findBatchImpl(*this, value(batchesIt));
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _getPrefixRange()
+// ----------------------------------------------------------------------------
+// Returns the range of the needle prefix looked up in the k-mers table, or the root range.
+
+template <typename TRange, typename TNeedle, typename TNeedleSize>
+inline TRange _getPrefixRange(Nothing const &, TRange rootRange, TNeedle const & /* needle */, TNeedleSize & needleEnd)
+{
+    needleEnd = 0;
+    return rootRange;
+}
+
+template <typename TSize, typename TSpec, typename TRange, typename TNeedle, typename TNeedleSize>
+inline TRange _getPrefixRange(KmersTable<TSize, TSpec> const & kmers, TRange rootRange, TNeedle const & needle,
+                              TNeedleSize & needleEnd)
+{
+    needleEnd = 0;
+
+    if (empty(kmers) || length(needle) < kmers.k)
+        return rootRange;
+
+    __uint64 kmer = 0;
+    for (; needleEnd < kmers.k; ++needleEnd)
+    {
+        unsigned needleOrd = ordValue(needle[needleEnd]);
+
+        // Ns have no k-mer and always mismatch.
+        if (needleOrd >= ValueSize<Dna>::VALUE)
+            return TRange(0, 0);
+
+        kmer = kmer * ValueSize<Dna>::VALUE + needleOrd;
+    }
+
+    return getRange(kmers, kmer);
+}
+
+// ----------------------------------------------------------------------------
+// Function _findBatchImpl()
+// ----------------------------------------------------------------------------
+// Searches the needles [batchBegin, batchBegin + BATCH) and reports their hits in order.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate, typename TNeedleId>
+inline void _findBatchImpl(BatchedFinder<TIndex, TKmersTable, TNeedles, TDelegate> & me, TNeedleId batchBegin)
+{
+    typedef BatchedFinder<TIndex, TKmersTable, TNeedles, TDelegate>     TFinder;
+    typedef typename TFinder::TIndexIt                                  TIndexIt;
+    typedef typename TFinder::TRange                                    TRange;
+    typedef typename TFinder::TNeedle                                   TNeedle;
+    typedef typename TFinder::TNeedleSize                               TNeedleSize;
+    typedef typename Fibre<TIndex, FibreLF>::Type                       TLF;
+    typedef typename Value<TIndex>::Type                                TAlphabet;
+    typedef typename Iterator<TNeedles, Rooted>::Type                   TNeedlesIt;
+
+    TLF const & lf = indexLF(me.index);
+    TIndexIt indexIt(me.index);
+
+    unsigned batchSize = std::min((TNeedleId)TFinder::BATCH, (TNeedleId)(length(me.needles) - batchBegin));
+
+    TRange ranges[TFinder::BATCH];
+    TNeedleSize needlesEnd[TFinder::BATCH];
+    unsigned char active[TFinder::BATCH];
+    unsigned activeCount = 0;
+
+    for (unsigned i = 0; i < batchSize; ++i)
+    {
+        TNeedle const & needle = me.needles[batchBegin + i];
+        ranges[i] = _getPrefixRange(me.kmers, TRange(range(indexIt)), needle, needlesEnd[i]);
+        active[i] = getValueI1(ranges[i]) < getValueI2(ranges[i]) && needlesEnd[i] < length(needle);
+        activeCount += active[i];
+    }
+
+    // Extend all active needles by one character per round.
+    while (activeCount > 0)
+    {
+        for (unsigned i = 0; i < batchSize; ++i)
+        {
+            if (!active[i]) continue;
+
+            TNeedle const & needle = me.needles[batchBegin + i];
+            unsigned needleOrd = ordValue(needle[needlesEnd[i]]);
+
+            if (needleOrd < ValueSize<TAlphabet>::VALUE)
+                ranges[i] = TRange(lf(getValueI1(ranges[i]), TAlphabet(needleOrd)),
+                                   lf(getValueI2(ranges[i]), TAlphabet(needleOrd)));
+            else
+                ranges[i] = TRange(0, 0);
+
+            if (getValueI1(ranges[i]) < getValueI2(ranges[i]) && ++needlesEnd[i] < length(needle))
+            {
+                prefetchRank(getFibre(lf, FibreBwt()), getValueI1(ranges[i]));
+                prefetchRank(getFibre(lf, FibreBwt()), getValueI2(ranges[i]));
+            }
+            else
+            {
+                active[i] = false;
+                --activeCount;
+            }
+        }
+    }
+
+    // Report the hits in the order of the needles.
+    for (unsigned i = 0; i < batchSize; ++i)
+    {
+        if (getValueI1(ranges[i]) >= getValueI2(ranges[i])) continue;
+
+        TIndexIt hitIt = indexIt;
+        value(hitIt).range = ranges[i];
+        TNeedlesIt needlesIt = iter(me.needles, batchBegin + i, Rooted());
+        me.delegate(hitIt, needlesIt, 0u);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function find()
+// ----------------------------------------------------------------------------
+// Finds all exact occurrences of the needles, the first k characters are looked up in the k-mers table if any.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate, typename TThreading>
+inline void find(TIndex & index, TKmersTable const & kmers, TNeedles & needles, TDelegate & delegate,
+                 Batched, TThreading const & threading)
+{
+    typedef BatchedFinder<TIndex, TKmersTable, TNeedles, TDelegate>     TFinder;
+    typedef typename TFinder::TNeedleId                                 TNeedleId;
+
+    String<TNeedleId> batches;
+    for (TNeedleId batchBegin = 0; batchBegin < length(needles); batchBegin += TFinder::BATCH)
+        appendValue(batches, batchBegin);
+
+    iterate(batches, TFinder(index, kmers, needles, delegate), Standard(), threading);
+}
+
+#endif  // #ifndef APP_YARA_FIND_BATCHED_H_
@@ -0,0 +1,202 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the backtracking search starting from a k-mers table.
+// ==========================================================================
+
+#ifndef APP_YARA_FIND_KMERS_H_
+#define APP_YARA_FIND_KMERS_H_
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class KmersFinder
+// ----------------------------------------------------------------------------
+// One instance per thread.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate>
+struct KmersFinder
+{
+    typedef typename Iterator<TIndex, TopDown<> >::Type     TIndexIt;
+
+    TIndex &                index;
+    TKmersTable const &     kmers;
+    TDelegate &             delegate;
+    unsigned                errors;
+
+    KmersFinder(TIndex & index, TKmersTable const & kmers, TDelegate & delegate, unsigned errors) :
+        index(index),
+        kmers(kmers),
+        delegate(delegate),
+        errors(errors)
+    {}
+
+    template <typename TNeedlesIt>
+    void operator() (TNeedlesIt const & needlesIt)
+    {
+        _findKmersImpl(*this, needlesIt);
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _findKmersImpl()
+// ----------------------------------------------------------------------------
+// Searches one needle, its first k characters are looked up in the table.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate, typename TNeedlesIt>
+inline void _findKmersImpl(KmersFinder<TIndex, TKmersTable, TNeedles, TDelegate> & me, TNeedlesIt const & needlesIt)
+{
+    typedef KmersFinder<TIndex, TKmersTable, TNeedles, TDelegate>   TFinder;
+    typedef typename TFinder::TIndexIt                              TIndexIt;
+    typedef typename Value<TNeedles>::Type                          TNeedle;
+    typedef typename Size<TNeedle>::Type                            TNeedleSize;
+
+    TNeedle const & needle = value(needlesIt);
+    TIndexIt indexIt(me.index);
+
+    // Needles shorter than k are searched from the root.
+    if (length(needle) < me.kmers.k)
+        _findBacktrackingImpl(me, indexIt, needlesIt, needle, TNeedleSize(0), range(indexIt), 0u);
+    else
+        _findKmerImpl(me, indexIt, needlesIt, needle, TNeedleSize(0), (__uint64)0, 0u);
+}
+
+// ----------------------------------------------------------------------------
+// Function _findKmerImpl()
+// ----------------------------------------------------------------------------
+// Enumerates the k-mers within the remaining errors from the needle prefix.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate,
+          typename TIndexIt, typename TNeedlesIt, typename TNeedle, typename TNeedleSize>
+inline void _findKmerImpl(KmersFinder<TIndex, TKmersTable, TNeedles, TDelegate> & me,
+                          TIndexIt const & indexIt,
+                          TNeedlesIt const & needlesIt,
+                          TNeedle const & needle,
+                          TNeedleSize needleEnd,
+                          __uint64 kmer,
+                          unsigned errors)
+{
+    typedef typename TKmersTable::TRange    TRange;
+
+    if (needleEnd == me.kmers.k)
+    {
+        TRange kmerRange = getRange(me.kmers, kmer);
+
+        if (getValueI1(kmerRange) < getValueI2(kmerRange))
+            _findBacktrackingImpl(me, indexIt, needlesIt, needle, needleEnd, kmerRange, errors);
+
+        return;
+    }
+
+    // Ns have no k-mer and always mismatch.
+    unsigned needleOrd = ordValue(needle[needleEnd]);
+
+    for (unsigned c = 0; c < ValueSize<Dna>::VALUE; ++c)
+    {
+        unsigned childErrors = errors + (c != needleOrd);
+
+        if (childErrors <= me.errors)
+            _findKmerImpl(me, indexIt, needlesIt, needle, needleEnd + 1,
+                          kmer * ValueSize<Dna>::VALUE + c, childErrors);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _findBacktrackingImpl()
+// ----------------------------------------------------------------------------
+// Extends the needle prefix [0, needleEnd) by one character.
+
+template <typename TIndex, typename TKmersTable, typename TNeedles, typename TDelegate,
+          typename TIndexIt, typename TNeedlesIt, typename TNeedle, typename TNeedleSize, typename TRange>
+inline void _findBacktrackingImpl(KmersFinder<TIndex, TKmersTable, TNeedles, TDelegate> & me,
+                                  TIndexIt const & indexIt,
+                                  TNeedlesIt const & needlesIt,
+                                  TNeedle const & needle,
+                                  TNeedleSize needleEnd,
+                                  TRange currRange,
+                                  unsigned errors)
+{
+    typedef typename Fibre<TIndex, FibreLF>::Type   TLF;
+    typedef typename Value<TIndex>::Type            TAlphabet;
+
+    static const unsigned SIGMA = ValueSize<TAlphabet>::VALUE;
+
+    if (needleEnd == length(needle))
+    {
+        TIndexIt hitIt = indexIt;
+        value(hitIt).range = currRange;
+        me.delegate(hitIt, needlesIt, errors);
+        return;
+    }
+
+    TLF const & lf = indexLF(me.index);
+    unsigned needleOrd = ordValue(needle[needleEnd]);
+
+    for (unsigned c = 0; c < SIGMA; ++c)
+    {
+        unsigned childErrors = errors + (c != needleOrd);
+
+        if (childErrors > me.errors)
+            continue;
+
+        TRange childRange(lf(getValueI1(currRange), TAlphabet(c)), lf(getValueI2(currRange), TAlphabet(c)));
+
+        if (getValueI1(childRange) < getValueI2(childRange))
+            _findBacktrackingImpl(me, indexIt, needlesIt, needle, needleEnd + 1, childRange, childErrors);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function find()
+// ----------------------------------------------------------------------------
+// Finds all occurrences of the needles within the given Hamming distance, skipping the first k LF steps.
+
+template <typename TIndex, typename TSize, typename TSpec, typename TNeedles, typename TDelegate, typename TDistance,
+          typename TThreading>
+inline void find(TIndex & index, KmersTable<TSize, TSpec> const & kmers, TNeedles & needles, unsigned errors,
+                 TDelegate & delegate, Backtracking<TDistance>, TThreading const & threading)
+{
+    typedef KmersFinder<TIndex, KmersTable<TSize, TSpec>, TNeedles, TDelegate>  TFinder;
+
+    iterate(needles, TFinder(index, kmers, delegate, errors), Rooted(), threading);
+}
+
+#endif  // #ifndef APP_YARA_FIND_KMERS_H_
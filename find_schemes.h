@@ -0,0 +1,320 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the search schemes for approximate needles on a bidirectional FM index.
+// ==========================================================================
+// The bidirectional index consists of the FM index of the reversed text and the LF fibre of the text.
+// The former extends the needle to the right, the latter extends the needle to the left.
+
+#ifndef APP_YARA_FIND_SCHEMES_H_
+#define APP_YARA_FIND_SCHEMES_H_
+
+using namespace seqan;
+
+// ============================================================================
+// Tags
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Tag SearchSchemes
+// ----------------------------------------------------------------------------
+
+struct SearchSchemes_;
+typedef Tag<SearchSchemes_> SearchSchemes;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class SearchScheme
+// ----------------------------------------------------------------------------
+// Searches the parts of the needle in the given order, with cumulative lower and upper error bounds per part.
+
+struct SearchScheme
+{
+    unsigned char   parts;
+    unsigned char   order[3];
+    unsigned char   lower[3];
+    unsigned char   upper[3];
+};
+
+// ----------------------------------------------------------------------------
+// Class SchemesFinder
+// ----------------------------------------------------------------------------
+// One instance per thread.
+
+template <typename TIndex, typename TRevLF, typename TNeedles, typename TDelegate>
+struct SchemesFinder
+{
+    typedef typename Iterator<TIndex, TopDown<> >::Type     TIndexIt;
+
+    TIndex &                index;
+    TRevLF const &          revLF;
+    TDelegate &             delegate;
+    SearchScheme const *    schemes;
+    unsigned                schemesCount;
+
+    SchemesFinder(TIndex & index, TRevLF const & revLF, TDelegate & delegate,
+                  SearchScheme const * schemes, unsigned schemesCount) :
+        index(index),
+        revLF(revLF),
+        delegate(delegate),
+        schemes(schemes),
+        schemesCount(schemesCount)
+    {}
+
+    template <typename TNeedlesIt>
+    void operator() (TNeedlesIt const & needlesIt)
+    {
+        _findSchemesImpl(*this, needlesIt);
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _getSearchSchemes()
+// ----------------------------------------------------------------------------
+// Returns the schemes for the given number of errors, or zero if there are none.
+// The cumulative bounds partition the error patterns (e0, e1, e2) of the parts: the first scheme
+// covers e0 = 0, the second e1 = e2 = 0 < e0, the third e2 = 0 < e1 = e0 and the last e1 = 0 < e2 = e0.
+// Thus each occurrence within the given errors is reported exactly once, as done by backtracking.
+
+inline unsigned _getSearchSchemes(SearchScheme const * & schemes, unsigned errors)
+{
+    static const SearchScheme schemes1[] =
+    {
+        { 2, { 0, 1 }, { 0, 0 }, { 0, 1 } },
+        { 2, { 1, 0 }, { 0, 1 }, { 0, 1 } }
+    };
+
+    static const SearchScheme schemes2[] =
+    {
+        { 3, { 0, 1, 2 }, { 0, 0, 0 }, { 0, 2, 2 } },
+        { 3, { 1, 2, 0 }, { 0, 0, 1 }, { 0, 0, 2 } },
+        { 3, { 2, 1, 0 }, { 0, 1, 2 }, { 0, 1, 2 } },
+        { 3, { 1, 2, 0 }, { 0, 1, 2 }, { 0, 1, 2 } }
+    };
+
+    switch (errors)
+    {
+    case 1:
+        schemes = schemes1;
+        return 2;
+
+    case 2:
+        schemes = schemes2;
+        return 4;
+
+    default:
+        schemes = 0;
+        return 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _isRightPart()
+// ----------------------------------------------------------------------------
+// Returns true if the part extends the needle to the right.
+
+inline bool _isRightPart(SearchScheme const & scheme, unsigned char part)
+{
+    return part == 0 || scheme.order[part] > scheme.order[0];
+}
+
+// ----------------------------------------------------------------------------
+// Function _needsMirror()
+// ----------------------------------------------------------------------------
+// Returns true if the search changes direction after the given part.
+
+inline bool _needsMirror(SearchScheme const & scheme, unsigned char part)
+{
+    for (unsigned char next = part + 1; next < scheme.parts; ++next)
+        if (_isRightPart(scheme, next) != _isRightPart(scheme, part))
+            return true;
+
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Function _findSchemesImpl()
+// ----------------------------------------------------------------------------
+// Searches one needle with all schemes.
+
+template <typename TIndex, typename TRevLF, typename TNeedles, typename TDelegate, typename TNeedlesIt>
+inline void _findSchemesImpl(SchemesFinder<TIndex, TRevLF, TNeedles, TDelegate> & me, TNeedlesIt const & needlesIt)
+{
+    typedef SchemesFinder<TIndex, TRevLF, TNeedles, TDelegate>  TFinder;
+    typedef typename TFinder::TIndexIt                          TIndexIt;
+    typedef typename Value<TNeedles>::Type                      TNeedle;
+    typedef typename Size<TNeedle>::Type                        TNeedleSize;
+
+    TNeedle const & needle = value(needlesIt);
+    TNeedleSize needleLength = length(needle);
+
+    TIndexIt indexIt(me.index);
+
+    for (unsigned schemeId = 0; schemeId < me.schemesCount; ++schemeId)
+    {
+        SearchScheme const & scheme = me.schemes[schemeId];
+
+        // Split the needle into parts of equal length.
+        TNeedleSize partsBegin[4];
+        for (unsigned char part = 0; part <= scheme.parts; ++part)
+            partsBegin[part] = part * needleLength / scheme.parts;
+
+        TNeedleSize needleBegin = partsBegin[scheme.order[0]];
+
+        _findSchemeImpl(me, indexIt, needlesIt, needle, scheme, partsBegin, 0u,
+                        needleBegin, needleBegin, range(indexIt), range(indexIt), 0u);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _findSchemeImpl()
+// ----------------------------------------------------------------------------
+// Searches the needle infix [needleBegin, needleEnd) with one scheme and extends it by one character.
+
+template <typename TIndex, typename TRevLF, typename TNeedles, typename TDelegate,
+          typename TIndexIt, typename TNeedlesIt, typename TNeedle, typename TNeedleSize, typename TRange>
+inline void _findSchemeImpl(SchemesFinder<TIndex, TRevLF, TNeedles, TDelegate> & me,
+                            TIndexIt const & indexIt,
+                            TNeedlesIt const & needlesIt,
+                            TNeedle const & needle,
+                            SearchScheme const & scheme,
+                            TNeedleSize const * partsBegin,
+                            unsigned part,
+                            TNeedleSize needleBegin,
+                            TNeedleSize needleEnd,
+                            TRange fwdRange,
+                            TRange revRange,
+                            unsigned errors)
+{
+    typedef typename Fibre<TIndex, FibreLF>::Type   TLF;
+    typedef typename Value<TIndex>::Type            TAlphabet;
+    typedef typename Size<TIndex>::Type             TSize;
+
+    static const unsigned SIGMA = ValueSize<TAlphabet>::VALUE;
+
+    bool right = _isRightPart(scheme, part);
+    TNeedleSize partBegin = partsBegin[scheme.order[part]];
+    TNeedleSize partEnd = partsBegin[scheme.order[part] + 1];
+
+    // Go to the next part.
+    if ((right && needleEnd == partEnd) || (!right && needleBegin == partBegin))
+    {
+        if (errors < scheme.lower[part])
+            return;
+
+        if (++part < scheme.parts)
+            return _findSchemeImpl(me, indexIt, needlesIt, needle, scheme, partsBegin, part,
+                                   needleBegin, needleEnd, fwdRange, revRange, errors);
+
+        TIndexIt hitIt = indexIt;
+        value(hitIt).range = fwdRange;
+        me.delegate(hitIt, needlesIt, errors);
+        return;
+    }
+
+    TLF const & lf = right ? indexLF(me.index) : me.revLF;
+    TRange const & currRange = right ? fwdRange : revRange;
+    TRange const & mirrorRange = right ? revRange : fwdRange;
+    unsigned needleOrd = ordValue(needle[right ? needleEnd : needleBegin - 1]);
+    // The reported range is the mirror range of the left parts, thus they always maintain it.
+    bool mirror = !right || _needsMirror(scheme, part);
+    bool exact = errors == scheme.upper[part];
+
+    // Extend the range by each character.
+    TRange childRanges[SIGMA];
+    TSize childrenSize = 0;
+    for (unsigned c = 0; c < SIGMA; ++c)
+    {
+        if (exact && !mirror && c != needleOrd)
+        {
+            childRanges[c] = TRange(0, 0);
+            continue;
+        }
+
+        childRanges[c] = TRange(lf(getValueI1(currRange), TAlphabet(c)), lf(getValueI2(currRange), TAlphabet(c)));
+        childrenSize += getValueI2(childRanges[c]) - getValueI1(childRanges[c]);
+    }
+
+    // The suffixes ending at a sentinel come first in the mirror range.
+    TSize mirrorBegin = getValueI1(mirrorRange);
+    if (mirror)
+        mirrorBegin += (getValueI2(currRange) - getValueI1(currRange)) - childrenSize;
+
+    for (unsigned c = 0; c < SIGMA; ++c)
+    {
+        TSize childSize = getValueI2(childRanges[c]) - getValueI1(childRanges[c]);
+        TRange childMirrorRange(mirrorBegin, mirrorBegin + childSize);
+        mirrorBegin += childSize;
+
+        unsigned childErrors = errors + (c != needleOrd);
+
+        if (!childSize || childErrors > scheme.upper[part])
+            continue;
+
+        if (right)
+            _findSchemeImpl(me, indexIt, needlesIt, needle, scheme, partsBegin, part,
+                            needleBegin, needleEnd + 1, childRanges[c], childMirrorRange, childErrors);
+        else
+            _findSchemeImpl(me, indexIt, needlesIt, needle, scheme, partsBegin, part,
+                            needleBegin - 1, needleEnd, childMirrorRange, childRanges[c], childErrors);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function find()
+// ----------------------------------------------------------------------------
+// Finds all occurrences of the needles within the given Hamming distance.
+
+template <typename TIndex, typename TRevLF, typename TNeedles, typename TDelegate, typename TThreading>
+inline void find(TIndex & index, TRevLF const & revLF, TNeedles & needles, unsigned errors,
+                 TDelegate & delegate, SearchSchemes, TThreading const & threading)
+{
+    typedef SchemesFinder<TIndex, TRevLF, TNeedles, TDelegate>  TFinder;
+
+    SearchScheme const * schemes;
+    unsigned schemesCount = _getSearchSchemes(schemes, errors);
+
+    if (!schemesCount)
+        return find(index, needles, errors, delegate, Backtracking<HammingDistance>(), threading);
+
+    iterate(needles, TFinder(index, revLF, delegate, schemes, schemesCount), Rooted(), threading);
+}
+
+#endif  // #ifndef APP_YARA_FIND_SCHEMES_H_
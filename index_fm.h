@@ -56,6 +56,597 @@ inline bool indexRequire(Index<StringSet<TText, TSSetSpec>,  FMIndex<TSpec, TCon
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// Class SuffixBuckets_
+// ----------------------------------------------------------------------------
+// The suffixes are distributed into buckets by their first characters. Sorting within a memory budget
+// keeps the suffixes of each part of the SA in a file, buffered by a few small pages.
+
+#ifdef YARA_INDEXER
+template <typename TSAValue>
+struct SuffixBuckets_
+{
+    static const unsigned PREFIX_LENGTH = 8;
+    static const unsigned PAGE_SIZE = 64 * 1024;
+    static const unsigned FRAMES = 2;
+
+    typedef String<TSAValue, External<ExternalConfig<File<>, PAGE_SIZE, FRAMES> > >    TPartFile;
+};
+
+// ----------------------------------------------------------------------------
+// Class SuffixLocalizer_
+// ----------------------------------------------------------------------------
+// Converts the global positions of the temporary SA into (string, offset) pairs, only one pair at a time.
+
+template <typename TText>
+struct SuffixLocalizer_ :
+    public std::unary_function<typename SAValue<TText>::Type, typename StringSetPosition<TText>::Type>
+{
+    typedef typename SAValue<TText>::Type               TSAValue;
+    typedef typename StringSetPosition<TText>::Type     TPos;
+    typedef typename StringSetLimits<TText const>::Type TLimits;
+
+    TLimits const * limits;
+
+    SuffixLocalizer_() :
+        limits()
+    {}
+
+    SuffixLocalizer_(TText const & text) :
+        limits(&stringSetLimits(text))
+    {}
+
+    inline TPos operator()(TSAValue textPos) const
+    {
+        TPos pos;
+        posLocalize(pos, textPos, *limits);
+        return pos;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Function _getSuffixBucketsCount()
+// ----------------------------------------------------------------------------
+
+template <typename TAlphabet>
+inline __uint64 _getSuffixBucketsCount(TAlphabet const & /* tag */, unsigned prefixLength)
+{
+    __uint64 bucketsCount = 1;
+    for (unsigned i = 0; i < prefixLength; ++i)
+        bucketsCount *= ValueSize<TAlphabet>::VALUE + 1;
+
+    return bucketsCount;
+}
+
+// ----------------------------------------------------------------------------
+// Function _getSuffixBucket()
+// ----------------------------------------------------------------------------
+// Returns the bucket of a suffix given its first characters; the end of a string comes before any character.
+
+template <typename TText, typename TSSetSpec, typename TPos>
+inline __uint64
+_getSuffixBucket(StringSet<TText, TSSetSpec> const & text, TPos suffixBegin, TPos suffixEnd, unsigned prefixLength)
+{
+    typedef typename Value<TText>::Type     TAlphabet;
+
+    __uint64 bucket = 0;
+
+    for (unsigned i = 0; i < prefixLength; ++i, ++suffixBegin)
+    {
+        bucket *= ValueSize<TAlphabet>::VALUE + 1;
+        if (suffixBegin < suffixEnd)
+            bucket += ordValue(concat(text)[suffixBegin]) + 1;
+    }
+
+    return bucket;
+}
+
+// ----------------------------------------------------------------------------
+// Function _getSuffixEnd()
+// ----------------------------------------------------------------------------
+// Returns the end of the string containing a global position, i.e. the first limit past it.
+
+template <typename TLimits, typename TPos>
+inline typename Value<TLimits>::Type
+_getSuffixEnd(TLimits const & limits, TPos textPos)
+{
+    typedef typename Value<TLimits>::Type   TLimit;
+
+    return *std::upper_bound(begin(limits, Standard()), end(limits, Standard()), static_cast<TLimit>(textPos));
+}
+
+// ----------------------------------------------------------------------------
+// Function _countSuffixBuckets()
+// ----------------------------------------------------------------------------
+// Computes the begin of each bucket of suffixes sharing their first characters.
+
+template <typename TBuckets, typename TText, typename TSSetSpec>
+inline void
+_countSuffixBuckets(TBuckets & buckets, StringSet<TText, TSSetSpec> const & text, unsigned prefixLength)
+{
+    typedef StringSet<TText, TSSetSpec>                     TStringSet;
+    typedef typename Value<TText>::Type                     TAlphabet;
+    typedef typename StringSetLimits<TStringSet const>::Type TLimits;
+
+    TLimits const & limits = stringSetLimits(text);
+    __int64 textLength = lengthSum(text);
+
+    clear(buckets);
+    resize(buckets, _getSuffixBucketsCount(TAlphabet(), prefixLength) + 1, 0, Exact());
+
+    // Count the suffixes in each bucket.
+    SEQAN_OMP_PRAGMA(parallel for schedule(static))
+    for (__int64 textPos = 0; textPos < textLength; ++textPos)
+    {
+        __uint64 bucket = _getSuffixBucket(text, textPos, (__int64)_getSuffixEnd(limits, textPos), prefixLength);
+        atomicInc(buckets[bucket + 1]);
+    }
+
+    // Compute the begin of each bucket.
+    partialSum(buckets, buckets, Serial());
+}
+
+// ----------------------------------------------------------------------------
+// Function _getSuffixKey()
+// ----------------------------------------------------------------------------
+// Returns the character of a (begin, end) suffix at some depth; the end of its string comes before any character.
+
+template <typename TText, typename TSSetSpec, typename TSuffix, typename TSize>
+inline unsigned _getSuffixKey(StringSet<TText, TSSetSpec> const & text, TSuffix const & suffix, TSize depth)
+{
+    return (suffix.i1 + depth < suffix.i2) ? ordValue(concat(text)[suffix.i1 + depth]) + 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function _sortSuffixBucket()
+// ----------------------------------------------------------------------------
+// Sorts (begin, end) suffixes equal up to depth by multikey quicksort: each partition step reads one character
+// per suffix and the suffixes equal on it go one character deeper, thus a common prefix is scanned once per
+// suffix rather than once per comparison. Equal suffixes come in decreasing string order, as in SuffixLess_.
+
+template <typename TSuffixes, typename TText, typename TSSetSpec, typename TStack>
+inline void _sortSuffixBucket(TSuffixes & suffixes, StringSet<TText, TSSetSpec> const & text, unsigned depth,
+                              TStack & stack)
+{
+    typedef typename Value<TSuffixes>::Type                 TSuffix;
+    typedef typename Value<TStack>::Type                    TFrame;
+
+    clear(stack);
+    appendValue(stack, TFrame(0u, length(suffixes), depth));
+
+    while (!empty(stack))
+    {
+        __uint64 lo = back(stack).i1;
+        __uint64 hi = back(stack).i2;
+        __uint64 d = back(stack).i3;
+        eraseBack(stack);
+
+        while (hi - lo > 1)
+        {
+            // Take the median of three characters as pivot.
+            unsigned k1 = _getSuffixKey(text, suffixes[lo], d);
+            unsigned k2 = _getSuffixKey(text, suffixes[lo + (hi - lo) / 2], d);
+            unsigned k3 = _getSuffixKey(text, suffixes[hi - 1], d);
+            unsigned pivot = std::max(std::min(k1, k2), std::min(std::max(k1, k2), k3));
+
+            // Partition into [lo, lt) < pivot, [lt, gt) == pivot, [gt, hi) > pivot.
+            __uint64 lt = lo;
+            __uint64 gt = hi;
+            for (__uint64 i = lo; i < gt; )
+            {
+                unsigned key = _getSuffixKey(text, suffixes[i], d);
+
+                if (key < pivot)
+                    std::swap(suffixes[lt++], suffixes[i++]);
+                else if (key > pivot)
+                    std::swap(suffixes[--gt], suffixes[i]);
+                else
+                    ++i;
+            }
+
+            if (lt - lo > 1) appendValue(stack, TFrame(lo, lt, d));
+            if (hi - gt > 1) appendValue(stack, TFrame(gt, hi, d));
+
+            // The suffixes ending at this depth are equal.
+            if (pivot == 0)
+            {
+                std::sort(begin(suffixes, Standard()) + lt, begin(suffixes, Standard()) + gt, std::greater<TSuffix>());
+                break;
+            }
+
+            lo = lt;
+            hi = gt;
+            ++d;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _sortSuffixBuckets()
+// ----------------------------------------------------------------------------
+// Sorts each bucket of [bucketsBegin, bucketsEnd) within sa, whose suffixes have already been distributed.
+// The suffixes of a bucket share their first prefixLength characters, thus their sort starts past them.
+
+template <typename TSA, typename TText, typename TSSetSpec, typename TBuckets>
+inline void
+_sortSuffixBuckets(TSA & sa, StringSet<TText, TSSetSpec> const & text, unsigned prefixLength,
+                   TBuckets const & buckets, __uint64 bucketsBegin, __uint64 bucketsEnd)
+{
+    typedef StringSet<TText, TSSetSpec>                     TStringSet;
+    typedef typename StringSetLimits<TStringSet const>::Type TLimits;
+    typedef typename Value<TSA>::Type                       TSAValue;
+    typedef typename Iterator<TSA, Standard>::Type          TSAIterator;
+    typedef Pair<TSAValue, TSAValue>                        TSuffix;
+    typedef Triple<__uint64, __uint64, __uint64>            TFrame;
+
+    TLimits const & limits = stringSetLimits(text);
+    __uint64 saOffset = buckets[bucketsBegin];
+    TSAIterator saBegin = begin(sa, Standard());
+
+    SEQAN_OMP_PRAGMA(parallel)
+    {
+        String<TSuffix> suffixes;
+        String<TFrame> stack;
+
+        SEQAN_OMP_PRAGMA(for schedule(dynamic))
+        for (__int64 bucket = bucketsBegin; bucket < (__int64)bucketsEnd; ++bucket)
+        {
+            TSAIterator bucketBegin = saBegin + (buckets[bucket] - saOffset);
+            __uint64 bucketLength = buckets[bucket + 1] - buckets[bucket];
+
+            if (bucketLength < 2) continue;
+
+            // Find the end of each suffix once.
+            resize(suffixes, bucketLength, Exact());
+            for (__uint64 i = 0; i < bucketLength; ++i)
+                suffixes[i] = TSuffix(bucketBegin[i], _getSuffixEnd(limits, bucketBegin[i]));
+
+            _sortSuffixBucket(suffixes, text, prefixLength, stack);
+
+            for (__uint64 i = 0; i < bucketLength; ++i)
+                bucketBegin[i] = suffixes[i].i1;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _createSuffixArrayParallel()
+// ----------------------------------------------------------------------------
+// Distributes the suffixes into buckets by their first characters and sorts the buckets independently.
+// The suffix order is the one of SuffixLess_, hence the SA is identical to that of Skew7.
+
+template <typename TSA, typename TText, typename TSSetSpec>
+inline void
+_createSuffixArrayParallel(TSA & sa, StringSet<TText, TSSetSpec> const & text, unsigned prefixLength)
+{
+    typedef StringSet<TText, TSSetSpec>                     TStringSet;
+    typedef typename StringSetLimits<TStringSet const>::Type TLimits;
+
+    TLimits const & limits = stringSetLimits(text);
+    __int64 textLength = lengthSum(text);
+
+    String<__uint64> buckets;
+    String<__uint64> bucketsPos;
+
+    _countSuffixBuckets(buckets, text, prefixLength);
+
+    resize(sa, textLength, Exact());
+    bucketsPos = buckets;
+
+    // Distribute the suffixes into their buckets.
+    SEQAN_OMP_PRAGMA(parallel for schedule(static))
+    for (__int64 textPos = 0; textPos < textLength; ++textPos)
+    {
+        __uint64 bucket = _getSuffixBucket(text, textPos, (__int64)_getSuffixEnd(limits, textPos), prefixLength);
+        sa[atomicInc(bucketsPos[bucket]) - 1] = textPos;
+    }
+
+    _sortSuffixBuckets(sa, text, prefixLength, buckets, 0u, length(buckets) - 1);
+}
+
+// ----------------------------------------------------------------------------
+// Function _createSuffixArrayExternal()
+// ----------------------------------------------------------------------------
+// Splits consecutive buckets into parts of at most maxLength suffixes and distributes the suffixes into one file
+// per part in a single pass over the text, then sorts one part at a time and appends it to the external SA.
+// A single bucket larger than maxLength is sorted in one part.
+
+template <typename TSA, typename TText, typename TSSetSpec, typename TSize, typename TDelegate>
+inline void
+_createSuffixArrayExternal(TSA & sa, StringSet<TText, TSSetSpec> const & text, unsigned prefixLength,
+                           TSize maxLength, TDelegate & delegate)
+{
+    typedef StringSet<TText, TSSetSpec>                     TStringSet;
+    typedef typename Value<TSA>::Type                       TSAValue;
+    typedef typename StringSetLimits<TStringSet const>::Type TLimits;
+    typedef typename SuffixBuckets_<TSAValue>::TPartFile    TPartFile;
+    typedef typename Iterator<TPartFile, Standard>::Type    TPartFileIterator;
+    typedef String<TSAValue>                                TPart;
+
+    TLimits const & limits = stringSetLimits(text);
+    __uint64 textLength = lengthSum(text);
+
+    String<__uint64> buckets;
+    String<__uint64> bucketsPos;
+    String<__uint64> parts;
+    String<__uint32> bucketsPart;
+    String<TPartFile> partFiles;
+    TPart part;
+
+    _countSuffixBuckets(buckets, text, prefixLength);
+
+    __uint64 bucketsCount = length(buckets) - 1;
+
+    // Take as many buckets per part as fit into it, but at least one.
+    resize(bucketsPart, bucketsCount, Exact());
+    appendValue(parts, 0u);
+    for (__uint64 partBegin = 0, partEnd = 0; partBegin < bucketsCount; partBegin = partEnd)
+    {
+        for (partEnd = partBegin + 1;
+             partEnd < bucketsCount && buckets[partEnd + 1] - buckets[partBegin] <= (__uint64)maxLength;
+             ++partEnd) ;
+
+        for (__uint64 bucket = partBegin; bucket < partEnd; ++bucket)
+            bucketsPart[bucket] = length(parts) - 1;
+
+        appendValue(parts, partEnd);
+    }
+
+    // Distribute the suffixes into their parts.
+    resize(partFiles, length(parts) - 1);
+    for (__uint64 textPos = 0; textPos < textLength; ++textPos)
+    {
+        __uint64 bucket = _getSuffixBucket(text, textPos, (__uint64)_getSuffixEnd(limits, textPos), prefixLength);
+        appendValue(partFiles[bucketsPart[bucket]], textPos);
+    }
+
+    clear(bucketsPart);
+    shrinkToFit(bucketsPart);
+    clear(sa);
+
+    for (__uint64 partId = 0; partId + 1 < length(parts); ++partId)
+    {
+        __uint64 partBegin = parts[partId];
+        __uint64 partEnd = parts[partId + 1];
+        __uint64 saOffset = buckets[partBegin];
+
+        // Distribute the suffixes of the part into their buckets.
+        resize(part, buckets[partEnd] - saOffset, Exact());
+
+        resize(bucketsPos, partEnd - partBegin, Exact());
+        for (__uint64 bucket = partBegin; bucket < partEnd; ++bucket)
+            bucketsPos[bucket - partBegin] = buckets[bucket] - saOffset;
+
+        TPartFileIterator partFileEnd = end(partFiles[partId], Standard());
+        for (TPartFileIterator partFileIt = begin(partFiles[partId], Standard()); partFileIt != partFileEnd; ++partFileIt)
+        {
+            TSAValue textPos = *partFileIt;
+            __uint64 bucket = _getSuffixBucket(text, textPos, (__uint64)_getSuffixEnd(limits, textPos), prefixLength);
+            part[bucketsPos[bucket - partBegin]++] = textPos;
+        }
+
+        clear(partFiles[partId]);
+
+        _sortSuffixBuckets(part, text, prefixLength, buckets, partBegin, partEnd);
+        append(sa, part);
+
+        delegate(buckets[partEnd], back(buckets));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function getSuffixArrayMemory()
+// ----------------------------------------------------------------------------
+// Returns the memory taken by sorting the SA in parts of partLength suffixes, besides the text.
+
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig, typename TSize>
+inline __uint64
+getSuffixArrayMemory(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > const & index, TSize partLength)
+{
+    typedef StringSet<TText, TSSetSpec>                                     TStringSet;
+    typedef typename SAValue<TStringSet>::Type                              TSAValue;
+    typedef typename Value<TText>::Type                                     TAlphabet;
+    typedef SuffixBuckets_<TSAValue>                                        TSuffixBuckets;
+
+    __uint64 textLength = lengthSum(indexText(index));
+    __uint64 bucketsCount = _getSuffixBucketsCount(TAlphabet(), TSuffixBuckets::PREFIX_LENGTH);
+    __uint64 partsCount = textLength / partLength + 1;
+
+    // The buckets, their positions within the part and their part.
+    __uint64 memory = bucketsCount * (2 * sizeof(__uint64) + sizeof(__uint32));
+
+    // The pages of the part files and the part in memory.
+    memory += partsCount * TSuffixBuckets::PAGE_SIZE * TSuffixBuckets::FRAMES * sizeof(TSAValue);
+    memory += partLength * sizeof(TSAValue);
+
+    return memory;
+}
+
+// ----------------------------------------------------------------------------
+// Function getIndexMemory()
+// ----------------------------------------------------------------------------
+// Returns the memory peak of building the LF table and the compressed SA from the SA on disk, text included.
+
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig>
+inline __uint64
+getIndexMemory(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > const & index, unsigned sampling)
+{
+    typedef Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> >    TIndex;
+    typedef typename Value<TText>::Type                                     TAlphabet;
+    typedef typename Fibre<TIndex, FibreSA>::Type                           TCompressedSA;
+    typedef typename Fibre<TCompressedSA, FibreSparseString>::Type          TSparseString;
+    typedef typename Fibre<TSparseString, FibreValues>::Type                TValues;
+    typedef typename Value<TValues>::Type                                   TCSAValue;
+
+    __uint64 textLength = lengthSum(indexText(index));
+
+    // The text and the BWT copied before building the rank dictionary of the LF table.
+    __uint64 memory = 2 * textLength * sizeof(TAlphabet);
+
+    // The rank dictionary of the BWT and the sentinels take at most four and two bits per base.
+    memory += textLength / 2 + textLength / 4;
+
+    // The indicators of the compressed SA with their ranks and its sampled values.
+    memory += textLength / 4 + textLength / sampling * sizeof(TCSAValue);
+
+    return memory;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Function _createCompressedSa()
+// ----------------------------------------------------------------------------
+// Samples the suffixes by their offset within their string, thus the LF walk never crosses a string border,
+// and stores the sampled suffixes as positions in the concatenation of all strings.
+// The sampling rate is only needed here, the lookup walks the LF table up to the next sampled suffix.
+
+#ifdef YARA_INDEXER
+template <typename TText, typename TSpec, typename TConfig, typename TSA, typename TLimits, typename TSize>
+inline void
+_createCompressedSa(CompressedSA<TText, TSpec, TConfig> & compressedSA, TSA const & sa, TLimits const & limits,
+                    TSize offset, unsigned sampling)
+{
+    typedef CompressedSA<TText, TSpec, TConfig>                         TCompressedSA;
+    typedef typename Fibre<TCompressedSA, FibreSparseString>::Type      TSparseString;
+    typedef typename Fibre<TSparseString, FibreIndicators>::Type        TIndicators;
+    typedef typename Fibre<TSparseString, FibreValues>::Type            TValues;
+    typedef typename Value<TValues>::Type                               TSAValue;
+    typedef typename Iterator<TSA const, Standard>::Type                TSAIterator;
+
+    TSparseString & sparseString = getFibre(compressedSA, FibreSparseString());
+    TIndicators & indicators = getFibre(sparseString, FibreIndicators());
+    TValues & values = getFibre(sparseString, FibreValues());
+
+    resize(compressedSA, length(sa) + offset, Exact());
+
+    TSAIterator saBegin = begin(sa, Standard());
+    TSAIterator saEnd = end(sa, Standard());
+
+    // The first offset suffixes are the empty suffixes of the strings and are never sampled.
+    TSize pos = 0;
+    for (; pos < offset; ++pos)
+        setValue(indicators, pos, false);
+
+    for (TSAIterator saIt = saBegin; saIt != saEnd; ++saIt, ++pos)
+        setValue(indicators, pos, getSeqOffset(*saIt) % sampling == 0);
+    updateRanks(indicators);
+
+    resize(values, getRank(indicators, length(sparseString) - 1), Exact());
+
+    TSize counter = 0;
+    pos = offset;
+    for (TSAIterator saIt = saBegin; saIt != saEnd; ++saIt, ++pos)
+        if (getValue(indicators, pos))
+            assignValue(values, counter++, (TSAValue)limits[getSeqNo(*saIt)] + getSeqOffset(*saIt));
+}
+
+// ----------------------------------------------------------------------------
+// Function _createFMIndex()
+// ----------------------------------------------------------------------------
+// Creates the LF table and the compressed SA from the full SA of global positions, localized on the fly.
+
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig, typename TSA>
+inline void _createFMIndex(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > & index, TSA const & sa,
+                           unsigned sampling)
+{
+    typedef StringSet<TText, TSSetSpec>                                 TStringSet;
+    typedef SuffixLocalizer_<TStringSet>                                TLocalizer;
+    typedef ModifiedString<TSA const, ModView<TLocalizer> >             TLocalSA;
+
+    TStringSet const & text = indexText(index);
+    TLocalSA localSA(sa, TLocalizer(text));
+
+    // Create the LF table.
+    createLF(indexLF(index), text, localSA);
+
+    // Set the FMIndex LF as the CompressedSA LF.
+    setFibre(indexSA(index), indexLF(index), FibreLF());
+
+    // Create the compressed SA.
+    _createCompressedSa(indexSA(index), localSA, stringSetLimits(text), countSequences(text), sampling);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Function indexCreate()
+// ----------------------------------------------------------------------------
+// This function is overloaded to build the index with multiple threads or within a memory budget.
+// The SA sampling rate is a runtime value, it does not change the layout of the index.
+// The full SA holds global positions, smaller than (string, offset) pairs, thus also the serial build sorts buckets.
+
+#ifdef YARA_INDEXER
+namespace seqan {
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig>
+inline bool indexCreate(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > & index, FibreSALF, Serial,
+                        unsigned sampling = TConfig::SAMPLING)
+{
+    typedef StringSet<TText, TSSetSpec>                                     TStringSet;
+    typedef typename SAValue<TStringSet>::Type                              TSAValue;
+    typedef String<TSAValue>                                                TTempSA;
+
+    TStringSet const & text = indexText(index);
+
+    if (empty(text))
+        return false;
+
+    TTempSA tempSA;
+
+    // Create the full SA, the indexer runs it on one thread.
+    _createSuffixArrayParallel(tempSA, text, SuffixBuckets_<TSAValue>::PREFIX_LENGTH);
+
+    _createFMIndex(index, tempSA, sampling);
+
+    return true;
+}
+
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig>
+inline bool indexCreate(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > & index, FibreSALF, Parallel,
+                        unsigned sampling = TConfig::SAMPLING)
+{
+    typedef StringSet<TText, TSSetSpec>                                     TStringSet;
+    typedef typename SAValue<TStringSet>::Type                              TSAValue;
+    typedef String<TSAValue>                                                TTempSA;
+
+    TStringSet const & text = indexText(index);
+
+    if (empty(text))
+        return false;
+
+    TTempSA tempSA;
+
+    // Create the full SA.
+    _createSuffixArrayParallel(tempSA, text, SuffixBuckets_<TSAValue>::PREFIX_LENGTH);
+
+    _createFMIndex(index, tempSA, sampling);
+
+    return true;
+}
+
+template <typename TText, typename TSSetSpec, typename TSpec, typename TConfig, typename TSize, typename TDelegate>
+inline bool indexCreate(Index<StringSet<TText, TSSetSpec>, FMIndex<TSpec, TConfig> > & index, FibreSALF, External<>,
+                        TSize maxLength, TDelegate & delegate, unsigned sampling = TConfig::SAMPLING)
+{
+    typedef StringSet<TText, TSSetSpec>                                     TStringSet;
+    typedef typename SAValue<TStringSet>::Type                              TSAValue;
+    typedef String<TSAValue, External<> >                                   TTempSA;
+
+    TStringSet const & text = indexText(index);
+
+    if (empty(text))
+        return false;
+
+    TTempSA tempSA;
+
+    // Create the full SA on disk.
+    _createSuffixArrayExternal(tempSA, text, SuffixBuckets_<TSAValue>::PREFIX_LENGTH, maxLength, delegate);
+
+    _createFMIndex(index, tempSA, sampling);
+
+    return true;
+}
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // Function save()
 // ----------------------------------------------------------------------------
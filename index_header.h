@@ -0,0 +1,216 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the IndexHeader class.
+// ==========================================================================
+
+#ifndef APP_YARA_INDEX_HEADER_H_
+#define APP_YARA_INDEX_HEADER_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class IndexHeader
+// ----------------------------------------------------------------------------
+// Describes the configuration a reference index was built with.
+
+struct IndexHeader
+{
+    // The version is increased whenever the index files change their format.
+    static const unsigned VERSION = 2;
+
+    unsigned            version;
+    unsigned            sampling;
+    bool                bidirectional;
+    bool                large;
+    bool                compressed;
+    unsigned            strands;
+    unsigned            kmers;
+    unsigned            repeats;
+    unsigned            repeatsThreshold;
+    String<__uint32>    shards;
+
+    IndexHeader() :
+        version(VERSION),
+        sampling(YaraFMIndexConfig<>::SAMPLING),
+        bidirectional(false),
+        large(false),
+        compressed(false),
+        strands(1),
+        kmers(0),
+        repeats(0),
+        repeatsThreshold(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+// Unknown keys are skipped, missing keys keep their default value; a header without version has version 0.
+
+template <typename TFileName>
+inline bool open(IndexHeader & me, TFileName const & fileName)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".hdr");
+    std::ifstream file(toCString(name));
+    if (!file.is_open()) return false;
+
+    std::string key;
+    unsigned value;
+
+    me.version = 0;
+    clear(me.shards);
+
+    while (file >> key >> value)
+    {
+        if (key == "version")
+            me.version = value;
+        else if (key == "shard")
+            appendValue(me.shards, value);
+        else if (key == "sampling")
+            me.sampling = value;
+        else if (key == "bidirectional")
+            me.bidirectional = value;
+        else if (key == "large")
+            me.large = value;
+        else if (key == "compressed")
+            me.compressed = value;
+        else if (key == "strands")
+            me.strands = value;
+        else if (key == "kmers")
+            me.kmers = value;
+        else if (key == "repeats")
+            me.repeats = value;
+        else if (key == "repeats-threshold")
+            me.repeatsThreshold = value;
+    }
+
+    if (!file.eof())
+        throw RuntimeError("Error while parsing reference index header.");
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TFileName>
+inline bool save(IndexHeader const & me, TFileName const & fileName)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".hdr");
+    std::ofstream file(toCString(name));
+    if (!file.is_open()) return false;
+
+    file << "version\t" << me.version << '\n';
+    file << "sampling\t" << me.sampling << '\n';
+    file << "bidirectional\t" << me.bidirectional << '\n';
+    file << "large\t" << me.large << '\n';
+    file << "compressed\t" << me.compressed << '\n';
+    file << "strands\t" << me.strands << '\n';
+    file << "kmers\t" << me.kmers << '\n';
+    file << "repeats\t" << me.repeats << '\n';
+    file << "repeats-threshold\t" << me.repeatsThreshold << '\n';
+    for (unsigned shardId = 0; shardId < length(me.shards); ++shardId)
+        file << "shard\t" << me.shards[shardId] << '\n';
+
+    return file.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function getShardsCount()
+// ----------------------------------------------------------------------------
+// Each shard is stored as the id of its first contig; an unsharded index stores none.
+
+template <typename TShards>
+inline unsigned getShardsCount(TShards const & shards)
+{
+    return empty(shards) ? 1 : length(shards);
+}
+
+// ----------------------------------------------------------------------------
+// Function getShardContigs()
+// ----------------------------------------------------------------------------
+// Returns the range of contig ids indexed by one shard.
+
+template <typename TShards, typename TContigsCount>
+inline Pair<__uint32>
+getShardContigs(TShards const & shards, unsigned shardId, TContigsCount contigsCount)
+{
+    if (empty(shards))
+        return Pair<__uint32>(0, contigsCount);
+
+    if (shardId + 1 < length(shards))
+        return Pair<__uint32>(shards[shardId], shards[shardId + 1]);
+
+    return Pair<__uint32>(shards[shardId], contigsCount);
+}
+
+// ----------------------------------------------------------------------------
+// Function getShardFile()
+// ----------------------------------------------------------------------------
+// The first shard is stored as <prefix>.*, the following ones as <prefix>.<shardId>.*,
+// thus appending a shard to an index keeps the files of its existing shards.
+
+template <typename TFileName>
+inline CharString getShardFile(unsigned shardId, TFileName const & fileName)
+{
+    CharString name = fileName;
+
+    if (shardId > 0)
+    {
+        std::stringstream suffix;
+        suffix << '.' << shardId;
+        append(name, suffix.str());
+    }
+
+    return name;
+}
+
+#endif  // #ifndef APP_YARA_INDEX_HEADER_H_
@@ -0,0 +1,159 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the KmersTable class.
+// ==========================================================================
+
+#ifndef APP_YARA_INDEX_KMERS_H_
+#define APP_YARA_INDEX_KMERS_H_
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class KmersTable
+// ----------------------------------------------------------------------------
+// Stores the suffix array range of each k-mer, indexed by the rank of the k-mer.
+
+template <typename TSize, typename TSpec = Alloc<> >
+struct KmersTable
+{
+    typedef Pair<TSize>             TRange;
+    typedef String<TRange, TSpec>   TRanges;
+
+    TRanges     ranges;
+    unsigned    k;
+
+    KmersTable() :
+        k(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function empty()
+// ----------------------------------------------------------------------------
+
+template <typename TSize, typename TSpec>
+inline bool empty(KmersTable<TSize, TSpec> const & me)
+{
+    return me.k == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function getRange()
+// ----------------------------------------------------------------------------
+
+template <typename TSize, typename TSpec, typename TKmer>
+inline typename KmersTable<TSize, TSpec>::TRange
+getRange(KmersTable<TSize, TSpec> const & me, TKmer kmer)
+{
+    return me.ranges[kmer];
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+// Walks the first k levels of the index, the empty ranges are not expanded.
+
+template <typename TSize, typename TSpec, typename TLF, typename TRange>
+inline void _buildKmersImpl(KmersTable<TSize, TSpec> & me, TLF const & lf, TRange range, unsigned depth, __uint64 kmer)
+{
+    if (depth == me.k)
+    {
+        me.ranges[kmer] = range;
+        return;
+    }
+
+    for (unsigned c = 0; c < ValueSize<Dna>::VALUE; ++c)
+    {
+        TRange childRange(lf(getValueI1(range), Dna(c)), lf(getValueI2(range), Dna(c)));
+
+        if (getValueI1(childRange) < getValueI2(childRange))
+            _buildKmersImpl(me, lf, childRange, depth + 1, kmer * ValueSize<Dna>::VALUE + c);
+    }
+}
+
+template <typename TSize, typename TSpec, typename TIndex>
+inline void build(KmersTable<TSize, TSpec> & me, TIndex & index, unsigned k)
+{
+    typedef KmersTable<TSize, TSpec>                        TKmersTable;
+    typedef typename TKmersTable::TRange                    TRange;
+    typedef typename Iterator<TIndex, TopDown<> >::Type     TIndexIt;
+
+    me.k = k;
+
+    clear(me.ranges);
+    resize(me.ranges, (__uint64)1 << (2 * k), TRange(0, 0), Exact());
+
+    TIndexIt indexIt(index);
+    _buildKmersImpl(me, indexLF(index), TRange(range(indexIt)), 0u, 0u);
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+template <typename TSize, typename TSpec, typename TFileName>
+inline bool open(KmersTable<TSize, TSpec> & me, TFileName const & fileName, int openMode)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".kmr");
+    if (!open(me.ranges, toCString(name), openMode)) return false;
+
+    for (me.k = 0; ((__uint64)1 << (2 * me.k)) < length(me.ranges); ++me.k) ;
+
+    return ((__uint64)1 << (2 * me.k)) == length(me.ranges);
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TSize, typename TSpec, typename TFileName>
+inline bool save(KmersTable<TSize, TSpec> const & me, TFileName const & fileName)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".kmr");
+    return save(me.ranges, toCString(name));
+}
+
+#endif  // #ifndef APP_YARA_INDEX_KMERS_H_
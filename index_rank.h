@@ -0,0 +1,563 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the Interleaved and SparseBits rank dictionaries.
+// ==========================================================================
+
+#ifndef APP_YARA_INDEX_RANK_H_
+#define APP_YARA_INDEX_RANK_H_
+
+namespace seqan {
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class RankDictionaryLine_
+// ----------------------------------------------------------------------------
+// Stores the counts of all symbols preceding a block next to the 2-bit packed symbols of the block,
+// thus a rank query on 64-byte lines touches a single cache line. Longer lines amortize the counts over more symbols.
+
+template <typename TSize, unsigned LINE_SIZE = 64>
+struct RankDictionaryLine_
+{
+    static const unsigned SIGMA             = ValueSize<Dna>::VALUE;
+    static const unsigned WORDS             = (LINE_SIZE - SIGMA * sizeof(TSize)) / sizeof(__uint64);
+    static const unsigned VALUES_PER_WORD   = 32;
+    static const unsigned VALUES            = WORDS * VALUES_PER_WORD;
+
+    TSize       counts[SIGMA];
+    __uint64    words[WORDS];
+
+    RankDictionaryLine_()
+    {
+        std::fill(counts, counts + SIGMA, 0);
+        std::fill(words, words + WORDS, 0);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class Interleaved RankDictionary
+// ----------------------------------------------------------------------------
+// A last line stores the total counts and the length of the dictionary.
+
+template <typename TSpec, unsigned LINE_SIZE>
+struct RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> >
+{
+    typedef typename Size<RankDictionary>::Type                     TSize;
+    typedef typename RankDictionaryFibreSpec<RankDictionary>::Type  TFibreSpec;
+    typedef RankDictionaryLine_<TSize, LINE_SIZE>                   TLine;
+    typedef String<TLine, TFibreSpec>                               TLines;
+
+    TLines  lines;
+    TSize   _length;
+
+    RankDictionary() :
+        _length(0)
+    {}
+
+    template <typename TText>
+    RankDictionary(TText const & text) :
+        _length(0)
+    {
+        createRankDictionary(*this, text);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class SparseBits RankDictionary
+// ----------------------------------------------------------------------------
+// Stores only the sorted positions of the set bits, e.g. of the few sentinels within the BWT.
+// A last position stores the length of the dictionary.
+
+template <typename TSpec>
+struct RankDictionary<bool, SparseBits<TSpec> >
+{
+    typedef typename Size<RankDictionary>::Type                     TSize;
+    typedef typename RankDictionaryFibreSpec<RankDictionary>::Type  TFibreSpec;
+    typedef String<TSize, TFibreSpec>                               TPositions;
+
+    TPositions  positions;
+
+    RankDictionary() {}
+
+    template <typename TText>
+    RankDictionary(TText const & text)
+    {
+        createRankDictionary(*this, text);
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _getWordMatches()
+// ----------------------------------------------------------------------------
+// Returns a word with the low bit set in each 2-bit slot equal to c.
+
+inline __uint64 _getWordMatches(__uint64 word, unsigned c)
+{
+    static const __uint64 LOW_BITS = 0x5555555555555555ull;
+
+    __uint64 mismatches = word ^ (LOW_BITS * c);
+    return ~(mismatches | (mismatches >> 1)) & LOW_BITS;
+}
+
+// ----------------------------------------------------------------------------
+// Function getRank()
+// ----------------------------------------------------------------------------
+// Returns the number of occurrences of c in [0, pos].
+
+template <typename TSpec, unsigned LINE_SIZE, typename TPos, typename TChar>
+inline typename Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const>::Type
+getRank(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict, TPos pos, TChar c)
+{
+    typedef RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > TRankDictionary;
+    typedef typename TRankDictionary::TLine                     TLine;
+    typedef typename TRankDictionary::TSize                     TSize;
+
+    TLine const & line = dict.lines[pos / TLine::VALUES];
+    unsigned linePos = pos % TLine::VALUES;
+    unsigned wordId = linePos / TLine::VALUES_PER_WORD;
+    unsigned wordPos = linePos % TLine::VALUES_PER_WORD;
+    unsigned ord = ordValue(Dna(c));
+
+    TSize rank = line.counts[ord];
+
+    for (unsigned w = 0; w < wordId; ++w)
+        rank += popCount(_getWordMatches(line.words[w], ord));
+
+    __uint64 mask = (wordPos + 1 == TLine::VALUES_PER_WORD) ? ~0ull : ((1ull << (2 * (wordPos + 1))) - 1);
+    rank += popCount(_getWordMatches(line.words[wordId], ord) & mask);
+
+    return rank;
+}
+
+// ----------------------------------------------------------------------------
+// Function prefetchRank()
+// ----------------------------------------------------------------------------
+// Prefetches the cache line answering the rank queries at pos, other rank dictionaries are not prefetched.
+
+template <typename TValue, typename TSpec, typename TPos>
+inline void prefetchRank(RankDictionary<TValue, TSpec> const & /* dict */, TPos /* pos */)
+{}
+
+template <typename TSpec, unsigned LINE_SIZE, typename TPos>
+inline void prefetchRank(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict, TPos pos)
+{
+    typedef typename RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> >::TLine    TLine;
+
+#if defined(__GNUC__)
+    TLine const * line = begin(dict.lines, Standard()) + pos / TLine::VALUES;
+    __builtin_prefetch(line);
+
+    // Lines longer than a cache line need also the cache line of the symbol.
+    if (LINE_SIZE > 64)
+        __builtin_prefetch(line->words + (pos % TLine::VALUES) / TLine::VALUES_PER_WORD);
+#else
+    ignoreUnusedVariableWarning(dict);
+    ignoreUnusedVariableWarning(pos);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Function getValue()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE, typename TPos>
+inline Dna getValue(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict, TPos pos)
+{
+    typedef typename RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> >::TLine    TLine;
+
+    TLine const & line = dict.lines[pos / TLine::VALUES];
+    unsigned linePos = pos % TLine::VALUES;
+
+    return Dna((line.words[linePos / TLine::VALUES_PER_WORD] >> (2 * (linePos % TLine::VALUES_PER_WORD))) & 3);
+}
+
+template <typename TSpec, unsigned LINE_SIZE, typename TPos>
+inline Dna getValue(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, TPos pos)
+{
+    return getValue(const_cast<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const &>(dict), pos);
+}
+
+// ----------------------------------------------------------------------------
+// Function setValue()
+// ----------------------------------------------------------------------------
+// The counts are only valid after calling updateRanks().
+
+template <typename TSpec, unsigned LINE_SIZE, typename TPos, typename TChar>
+inline void setValue(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, TPos pos, TChar c)
+{
+    typedef typename RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> >::TLine    TLine;
+
+    TLine & line = dict.lines[pos / TLine::VALUES];
+    unsigned linePos = pos % TLine::VALUES;
+    unsigned shift = 2 * (linePos % TLine::VALUES_PER_WORD);
+    __uint64 & word = line.words[linePos / TLine::VALUES_PER_WORD];
+
+    word = (word & ~(3ull << shift)) | ((__uint64)ordValue(Dna(c)) << shift);
+}
+
+// ----------------------------------------------------------------------------
+// Function updateRanks()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline void updateRanks(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict)
+{
+    typedef RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > TRankDictionary;
+    typedef typename TRankDictionary::TLine                     TLine;
+    typedef typename TRankDictionary::TSize                     TSize;
+
+    if (empty(dict.lines)) return;
+
+    TSize counts[TLine::SIGMA];
+    std::fill(counts, counts + TLine::SIGMA, 0);
+
+    TSize linesCount = length(dict.lines) - 1;
+
+    for (TSize lineId = 0; lineId < linesCount; ++lineId)
+    {
+        TLine & line = dict.lines[lineId];
+        std::copy(counts, counts + TLine::SIGMA, line.counts);
+
+        // The padding after the last symbol is not counted.
+        TSize lineLength = std::min((TSize)TLine::VALUES, (TSize)(dict._length - lineId * TLine::VALUES));
+
+        for (unsigned c = 0; c < TLine::SIGMA; ++c)
+            counts[c] = getRank(dict, lineId * TLine::VALUES + lineLength - 1, Dna(c));
+    }
+
+    TLine & last = back(dict.lines);
+    std::copy(counts, counts + TLine::SIGMA, last.counts);
+    std::fill(last.words, last.words + TLine::WORDS, 0);
+    last.words[0] = dict._length;
+}
+
+// ----------------------------------------------------------------------------
+// Function length()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline typename Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const>::Type
+length(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict)
+{
+    return dict._length;
+}
+
+// ----------------------------------------------------------------------------
+// Function empty()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline bool empty(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict)
+{
+    return dict._length == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline void clear(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict)
+{
+    clear(dict.lines);
+    dict._length = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function resize()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE, typename TSize, typename TExpand>
+inline typename Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >::Type
+resize(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, TSize newLength, Tag<TExpand> const tag)
+{
+    typedef typename RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> >::TLine    TLine;
+
+    dict._length = newLength;
+    resize(dict.lines, (newLength + TLine::VALUES - 1) / TLine::VALUES + 1, TLine(), tag);
+
+    return dict._length;
+}
+
+template <typename TSpec, unsigned LINE_SIZE, typename TSize>
+inline typename Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >::Type
+resize(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, TSize newLength)
+{
+    return resize(dict, newLength, Exact());
+}
+
+// ----------------------------------------------------------------------------
+// Function createRankDictionary()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE, typename TText>
+inline void createRankDictionary(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, TText const & text)
+{
+    typedef typename Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >::Type  TSize;
+
+    resize(dict, length(text), Exact());
+
+    for (TSize pos = 0; pos < length(text); ++pos)
+        setValue(dict, pos, text[pos]);
+
+    updateRanks(dict);
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline bool open(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, const char * fileName, int openMode)
+{
+    if (!open(dict.lines, fileName, openMode) || empty(dict.lines)) return false;
+
+    dict._length = back(dict.lines).words[0];
+
+    return true;
+}
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline bool open(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > & dict, const char * fileName)
+{
+    return open(dict, fileName, DefaultOpenMode<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >::VALUE);
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline bool save(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict, const char * fileName, int openMode)
+{
+    return save(dict.lines, fileName, openMode);
+}
+
+template <typename TSpec, unsigned LINE_SIZE>
+inline bool save(RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > const & dict, const char * fileName)
+{
+    return save(dict, fileName, DefaultOpenMode<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >::VALUE);
+}
+
+// ----------------------------------------------------------------------------
+// Function getRank()
+// ----------------------------------------------------------------------------
+// Returns the number of bits equal to c in [0, pos].
+
+template <typename TSpec, typename TPos>
+inline typename Size<RankDictionary<bool, SparseBits<TSpec> > const>::Type
+getRank(RankDictionary<bool, SparseBits<TSpec> > const & dict, TPos pos, bool c = true)
+{
+    typedef RankDictionary<bool, SparseBits<TSpec> >                        TRankDictionary;
+    typedef typename TRankDictionary::TSize                                 TSize;
+    typedef typename Iterator<typename TRankDictionary::TPositions const, Standard>::Type TPositionsIt;
+
+    TPositionsIt pBegin = begin(dict.positions, Standard());
+    TPositionsIt pEnd = end(dict.positions, Standard()) - 1;
+
+    TSize rank = std::upper_bound(pBegin, pEnd, static_cast<TSize>(pos)) - pBegin;
+
+    return c ? rank : pos + 1 - rank;
+}
+
+// ----------------------------------------------------------------------------
+// Function getValue()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TPos>
+inline bool getValue(RankDictionary<bool, SparseBits<TSpec> > const & dict, TPos pos)
+{
+    typedef RankDictionary<bool, SparseBits<TSpec> >                        TRankDictionary;
+    typedef typename TRankDictionary::TSize                                 TSize;
+
+    return std::binary_search(begin(dict.positions, Standard()), end(dict.positions, Standard()) - 1,
+                              static_cast<TSize>(pos));
+}
+
+template <typename TSpec, typename TPos>
+inline bool getValue(RankDictionary<bool, SparseBits<TSpec> > & dict, TPos pos)
+{
+    return getValue(const_cast<RankDictionary<bool, SparseBits<TSpec> > const &>(dict), pos);
+}
+
+// ----------------------------------------------------------------------------
+// Function setValue()
+// ----------------------------------------------------------------------------
+// The bits are usually set in increasing order, thus clearing the bits past the last set bit is free.
+
+template <typename TSpec, typename TPos, typename TChar>
+inline void setValue(RankDictionary<bool, SparseBits<TSpec> > & dict, TPos pos, TChar c)
+{
+    typedef RankDictionary<bool, SparseBits<TSpec> >                        TRankDictionary;
+    typedef typename TRankDictionary::TSize                                 TSize;
+    typedef typename Iterator<typename TRankDictionary::TPositions, Standard>::Type TPositionsIt;
+
+    TPositionsIt pBegin = begin(dict.positions, Standard());
+    TPositionsIt pEnd = end(dict.positions, Standard()) - 1;
+
+    if (!c && (pBegin == pEnd || *(pEnd - 1) < static_cast<TSize>(pos))) return;
+
+    TPositionsIt pIt = std::lower_bound(pBegin, pEnd, static_cast<TSize>(pos));
+    bool isSet = (pIt != pEnd && *pIt == static_cast<TSize>(pos));
+
+    if (c && !isSet)
+        insertValue(dict.positions, pIt - pBegin, static_cast<TSize>(pos));
+    else if (!c && isSet)
+        erase(dict.positions, pIt - pBegin);
+}
+
+// ----------------------------------------------------------------------------
+// Function updateRanks()
+// ----------------------------------------------------------------------------
+// The ranks are computed on the fly.
+
+template <typename TSpec>
+inline void updateRanks(RankDictionary<bool, SparseBits<TSpec> > & /* dict */)
+{}
+
+// ----------------------------------------------------------------------------
+// Function length()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline typename Size<RankDictionary<bool, SparseBits<TSpec> > const>::Type
+length(RankDictionary<bool, SparseBits<TSpec> > const & dict)
+{
+    return empty(dict.positions) ? 0 : back(dict.positions);
+}
+
+// ----------------------------------------------------------------------------
+// Function empty()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline bool empty(RankDictionary<bool, SparseBits<TSpec> > const & dict)
+{
+    return length(dict) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline void clear(RankDictionary<bool, SparseBits<TSpec> > & dict)
+{
+    clear(dict.positions);
+}
+
+// ----------------------------------------------------------------------------
+// Function resize()
+// ----------------------------------------------------------------------------
+// The bits past the new length are dropped, new bits are clear.
+
+template <typename TSpec, typename TSize, typename TExpand>
+inline typename Size<RankDictionary<bool, SparseBits<TSpec> > >::Type
+resize(RankDictionary<bool, SparseBits<TSpec> > & dict, TSize newLength, Tag<TExpand> const tag)
+{
+    typedef typename Size<RankDictionary<bool, SparseBits<TSpec> > >::Type  TDictSize;
+
+    TDictSize setBits = empty(dict.positions) ? 0 : getRank(dict, newLength) - getValue(dict, newLength);
+
+    resize(dict.positions, setBits + 1, tag);
+    back(dict.positions) = newLength;
+
+    return newLength;
+}
+
+template <typename TSpec, typename TSize>
+inline typename Size<RankDictionary<bool, SparseBits<TSpec> > >::Type
+resize(RankDictionary<bool, SparseBits<TSpec> > & dict, TSize newLength)
+{
+    return resize(dict, newLength, Exact());
+}
+
+// ----------------------------------------------------------------------------
+// Function createRankDictionary()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TText>
+inline void createRankDictionary(RankDictionary<bool, SparseBits<TSpec> > & dict, TText const & text)
+{
+    typedef typename Size<RankDictionary<bool, SparseBits<TSpec> > >::Type  TSize;
+
+    clear(dict);
+    resize(dict, length(text), Exact());
+
+    for (TSize pos = 0; pos < length(text); ++pos)
+        if (text[pos])
+            setValue(dict, pos, true);
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline bool open(RankDictionary<bool, SparseBits<TSpec> > & dict, const char * fileName, int openMode)
+{
+    return open(dict.positions, fileName, openMode) && !empty(dict.positions);
+}
+
+template <typename TSpec>
+inline bool open(RankDictionary<bool, SparseBits<TSpec> > & dict, const char * fileName)
+{
+    return open(dict, fileName, DefaultOpenMode<RankDictionary<bool, SparseBits<TSpec> > >::VALUE);
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline bool save(RankDictionary<bool, SparseBits<TSpec> > const & dict, const char * fileName, int openMode)
+{
+    return save(dict.positions, fileName, openMode);
+}
+
+template <typename TSpec>
+inline bool save(RankDictionary<bool, SparseBits<TSpec> > const & dict, const char * fileName)
+{
+    return save(dict, fileName, DefaultOpenMode<RankDictionary<bool, SparseBits<TSpec> > >::VALUE);
+}
+
+}
+
+#endif  // #ifndef APP_YARA_INDEX_RANK_H_
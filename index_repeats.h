@@ -0,0 +1,237 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the RepeatsTable class.
+// ==========================================================================
+
+#ifndef APP_YARA_INDEX_REPEATS_H_
+#define APP_YARA_INDEX_REPEATS_H_
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class RepeatsTable
+// ----------------------------------------------------------------------------
+// Stores the occurrences count of the frequent k-mers, sorted by the rank of the k-mer.
+
+template <typename TSpec = Alloc<> >
+struct RepeatsTable
+{
+    typedef Pair<__uint64>          TRepeat;
+    typedef String<TRepeat, TSpec>  TRepeats;
+
+    TRepeats    repeats;
+    unsigned    k;
+
+    RepeatsTable() :
+        k(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function empty()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline bool empty(RepeatsTable<TSpec> const & me)
+{
+    return me.k == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function _getKmerCount()
+// ----------------------------------------------------------------------------
+// Returns zero for the k-mers that are not frequent.
+
+template <typename TSpec>
+inline __uint64 _getKmerCount(RepeatsTable<TSpec> const & me, __uint64 kmer)
+{
+    typedef RepeatsTable<TSpec>                                 TRepeatsTable;
+    typedef typename TRepeatsTable::TRepeat                     TRepeat;
+    typedef typename TRepeatsTable::TRepeats const              TRepeats;
+    typedef typename Iterator<TRepeats, Standard>::Type         TRepeatsIt;
+
+    TRepeatsIt it = std::lower_bound(begin(me.repeats, Standard()), end(me.repeats, Standard()), TRepeat(kmer, 0));
+
+    return (it != end(me.repeats, Standard()) && getValueI1(*it) == kmer) ? getValueI2(*it) : 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function getCount()
+// ----------------------------------------------------------------------------
+// Bounds the occurrences count of a needle by the least frequent of its k-mers.
+// Returns zero for needles shorter than k or containing Ns.
+
+template <typename TSpec, typename TNeedle>
+inline __uint64 getCount(RepeatsTable<TSpec> const & me, TNeedle const & needle)
+{
+    typedef typename Iterator<TNeedle const, Standard>::Type    TNeedleIt;
+
+    if (empty(me) || length(needle) < me.k) return 0;
+
+    __uint64 kmerMask = MaxValue<__uint64>::VALUE >> (64 - 2 * me.k);
+    __uint64 kmer = 0;
+    __uint64 count = MaxValue<__uint64>::VALUE;
+
+    TNeedleIt nBegin = begin(needle, Standard());
+    TNeedleIt nEnd = end(needle, Standard());
+
+    for (TNeedleIt nIt = nBegin; nIt != nEnd && count > 0; ++nIt)
+    {
+        unsigned c = ordValue(Dna5(value(nIt)));
+
+        if (c >= ValueSize<Dna>::VALUE) return 0;
+
+        kmer = ((kmer << 2) | c) & kmerMask;
+
+        if (static_cast<unsigned>(nIt - nBegin) + 1 >= me.k)
+            count = std::min(count, _getKmerCount(me, kmer));
+    }
+
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+// Walks the first k levels of the index, the ranges smaller than the threshold are not expanded.
+// The index is built on the reversed contigs, thus the k-mers are extended to the right.
+
+template <typename TSpec, typename TLF, typename TRange>
+inline void _buildRepeatsImpl(RepeatsTable<TSpec> & me, TLF const & lf, TRange range, unsigned depth, __uint64 kmer,
+                              __uint64 threshold)
+{
+    typedef typename RepeatsTable<TSpec>::TRepeat   TRepeat;
+
+    if (depth == me.k)
+    {
+        appendValue(me.repeats, TRepeat(kmer, getValueI2(range) - getValueI1(range)));
+        return;
+    }
+
+    for (unsigned c = 0; c < ValueSize<Dna>::VALUE; ++c)
+    {
+        TRange childRange(lf(getValueI1(range), Dna(c)), lf(getValueI2(range), Dna(c)));
+
+        if (getValueI2(childRange) - getValueI1(childRange) >= threshold)
+            _buildRepeatsImpl(me, lf, childRange, depth + 1, kmer * ValueSize<Dna>::VALUE + c, threshold);
+    }
+}
+
+template <typename TSpec, typename TIndex>
+inline void build(RepeatsTable<TSpec> & me, TIndex & index, unsigned k, __uint64 threshold)
+{
+    typedef typename Size<TIndex>::Type                     TSize;
+    typedef Pair<TSize>                                     TRange;
+    typedef typename Iterator<TIndex, TopDown<> >::Type     TIndexIt;
+
+    me.k = k;
+
+    clear(me.repeats);
+
+    TIndexIt indexIt(index);
+    _buildRepeatsImpl(me, indexLF(index), TRange(range(indexIt)), 0u, 0u, std::max(threshold, (__uint64)1));
+}
+
+// ----------------------------------------------------------------------------
+// Function merge()
+// ----------------------------------------------------------------------------
+// Adds the counts of another table, e.g. built on another shard.
+
+template <typename TSpec>
+inline void merge(RepeatsTable<TSpec> & me, RepeatsTable<TSpec> const & other)
+{
+    typedef RepeatsTable<TSpec>                                 TRepeatsTable;
+    typedef typename TRepeatsTable::TRepeats                    TRepeats;
+    typedef typename Iterator<TRepeats const, Standard>::Type   TRepeatsIt;
+
+    TRepeats merged;
+    reserve(merged, length(me.repeats) + length(other.repeats), Exact());
+
+    TRepeatsIt it = begin(me.repeats, Standard());
+    TRepeatsIt itEnd = end(me.repeats, Standard());
+    TRepeatsIt otherIt = begin(other.repeats, Standard());
+    TRepeatsIt otherEnd = end(other.repeats, Standard());
+
+    while (it != itEnd || otherIt != otherEnd)
+    {
+        if (otherIt == otherEnd || (it != itEnd && getValueI1(*it) < getValueI1(*otherIt)))
+            appendValue(merged, *it++);
+        else if (it == itEnd || getValueI1(*otherIt) < getValueI1(*it))
+            appendValue(merged, *otherIt++);
+        else
+            appendValue(merged, typename TRepeatsTable::TRepeat(getValueI1(*it), getValueI2(*it++) + getValueI2(*otherIt++)));
+    }
+
+    me.k = other.k;
+    swap(me.repeats, merged);
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+// The length of the k-mers is stored in the index header.
+
+template <typename TSpec, typename TFileName>
+inline bool open(RepeatsTable<TSpec> & me, TFileName const & fileName, unsigned k, int openMode)
+{
+    CharString name;
+
+    me.k = k;
+
+    name = fileName;    append(name, ".rpt");
+    return open(me.repeats, toCString(name), openMode);
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TFileName>
+inline bool save(RepeatsTable<TSpec> const & me, TFileName const & fileName)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".rpt");
+    return save(me.repeats, toCString(name));
+}
+
+#endif  // #ifndef APP_YARA_INDEX_REPEATS_H_
@@ -49,6 +49,7 @@
 #include <seqan/sequence.h>
 #include <seqan/store.h>
 #include <seqan/index.h>
+#include <seqan/parallel.h>
 
 // ----------------------------------------------------------------------------
 // I/O and options
@@ -63,7 +64,11 @@
 #include "misc_timer.h"
 #include "misc_options.h"
 #include "misc_types.h"
+#include "index_rank.h"
 #include "index_fm.h"
+#include "index_kmers.h"
+#include "index_repeats.h"
+#include "index_header.h"
 
 using namespace seqan;
 
@@ -77,30 +82,93 @@ using namespace seqan;
 
 struct Options
 {
+    typedef std::string             TString;
+    typedef std::vector<TString>    TList;
+
     CharString genomeFile;
+    StringSet<CharString> genomeFiles;
     CharString genomeIndexFile;
-
-    bool    verbose;
+    bool        genomeAppend;
+
+    IndexType   genomeIndexType;
+    TList       indexTypeList;
+    unsigned    indexSampling;
+    bool        indexBidirectional;
+    bool        indexCompressed;
+    bool        indexDoubleStranded;
+    bool        indexLarge;
+    unsigned    indexShards;
+    unsigned    indexKmers;
+    unsigned    indexRepeats;
+    unsigned    repeatsThreshold;
+    unsigned    shardRepeatsThreshold;
+
+    unsigned    threadsCount;
+    unsigned    maxMemory;
+    bool        verbose;
 
     Options() :
+        genomeAppend(false),
+        genomeIndexType(FM_INDEX),
+        indexSampling(YaraFMIndexConfig<>::SAMPLING),
+        indexBidirectional(false),
+        indexCompressed(false),
+        indexDoubleStranded(false),
+        indexLarge(false),
+        indexShards(1),
+        indexKmers(0),
+        indexRepeats(0),
+        repeatsThreshold(300),
+        shardRepeatsThreshold(0),
+        threadsCount(1),
+        maxMemory(0),
         verbose(false)
+    {
+        appendValue(indexTypeList, "fm");
+        appendValue(indexTypeList, "qgram");
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class SortingProgress
+// ----------------------------------------------------------------------------
+// Reports the fraction of suffixes sorted so far.
+
+struct SortingProgress
+{
+    bool verbose;
+
+    SortingProgress(bool verbose) :
+        verbose(verbose)
     {}
+
+    template <typename TSize>
+    void operator() (TSize sorted, TSize total)
+    {
+        if (verbose)
+            std::cout << "Sorted suffixes:\t\t\t" << (100 * sorted / total) << "%" << std::endl;
+    }
 };
 
 // ----------------------------------------------------------------------------
 // Class Indexer
 // ----------------------------------------------------------------------------
 
-template <typename TIndexSpec, typename TSpec = void>
+template <typename TIndexConfig, typename TSpec = void>
 struct Indexer
 {
-    typedef Contigs<TSpec>                         TContigs;
-    typedef ContigsLoader<TSpec>                   TContigsLoader;
-    typedef Index<YaraContigsFM, TIndexSpec>       TIndex;
+    typedef Contigs<TSpec>                                                  TContigs;
+    typedef ContigsLoader<TSpec>                                            TContigsLoader;
+    typedef typename YaraIndexText<typename TIndexConfig::TSizeSpec>::Type  TIndexText;
+    typedef Index<TIndexText, FMIndex<void, TIndexConfig> >                 TIndex;
+    typedef KmersTable<typename Size<TIndex>::Type>                         TKmersTable;
+    typedef RepeatsTable<>                                                  TRepeatsTable;
 
     TContigs            contigs;
-    TContigsLoader      contigsLoader;
     TIndex              index;
+    TKmersTable         kmers;
+    TRepeatsTable       repeats;
+    String<__uint32>    shards;
     Timer<double>       timer;
 };
 
@@ -112,7 +180,7 @@ struct Indexer
 // Function setupArgumentParser()
 // ----------------------------------------------------------------------------
 
-void setupArgumentParser(ArgumentParser & parser, Options const & /* options */)
+void setupArgumentParser(ArgumentParser & parser, Options const & options)
 {
     setAppName(parser, "yara_indexer");
     setShortDescription(parser, "Yara Indexer");
@@ -121,21 +189,72 @@ void setupArgumentParser(ArgumentParser & parser, Options const & /* options */)
     setDateAndVersion(parser);
     setDescription(parser);
 
-    addUsageLine(parser, "[\\fIOPTIONS\\fP] <\\fIREFERENCE FILE\\fP>");
+    addUsageLine(parser, "[\\fIOPTIONS\\fP] <\\fIREFERENCE FILE\\fP> [<\\fIREFERENCE FILE\\fP> ...]");
 
-    addArgument(parser, ArgParseArgument(ArgParseArgument::INPUTFILE));
+    addArgument(parser, ArgParseArgument(ArgParseArgument::INPUTFILE, "REFERENCE", true));
     setValidValues(parser, 0, "fasta fa");
-    setHelpText(parser, 0, "A reference genome file.");
+    setHelpText(parser, 0, "One or more reference genome files.");
 
     addOption(parser, ArgParseOption("v", "verbose", "Displays verbose output."));
 
     addSection(parser, "Input Options");
 
     setIndexPrefix(parser);
-    
+
+    addOption(parser, ArgParseOption("", "append", "Append the contigs to the existing index with the same prefix, indexed as one more shard."));
+
     addSection(parser, "Output Options");
 
     setTmpFolder(parser);
+
+    addSection(parser, "Index Options");
+
+    setIndexType(parser, options);
+
+    addOption(parser, ArgParseOption("s", "sampling", "Suffix array sampling rate. Use 1 for the fastest locate.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "sampling", "1");
+    setDefaultValue(parser, "sampling", options.indexSampling);
+
+    addOption(parser, ArgParseOption("b", "bidirectional", "Build a bidirectional index for faster approximate search."));
+
+    addOption(parser, ArgParseOption("", "compressed", "Build a smaller index for machines with little memory, at some speed cost."));
+
+    addOption(parser, ArgParseOption("", "double-stranded", "Index both strands of the reference, the mapper then searches only the forward reads."));
+
+    addOption(parser, ArgParseOption("", "shards", "Split the reference into this number of indices, the mapper loads one at a time.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "shards", "1");
+    setDefaultValue(parser, "shards", options.indexShards);
+
+    addOption(parser, ArgParseOption("k", "kmers", "Length of the q-grams of the q-gram index. Default: 12.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "kmers", "1");
+    setMaxValue(parser, "kmers", "14");
+
+    addOption(parser, ArgParseOption("", "repeats", "Annotate the frequent k-mers of this length to classify repetitive reads before searching them.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "repeats", "8");
+    setMaxValue(parser, "repeats", "32");
+
+    addOption(parser, ArgParseOption("", "repeats-threshold", "Minimum number of occurrences of a frequent k-mer.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "repeats-threshold", "1");
+    setDefaultValue(parser, "repeats-threshold", options.repeatsThreshold);
+
+    addSection(parser, "Performance Options");
+
+    addOption(parser, ArgParseOption("m", "max-memory", "Maximum memory in megabytes to build the index. Default: unlimited.",
+                                     ArgParseOption::INTEGER));
+    setMinValue(parser, "max-memory", "1");
+
+#ifdef _OPENMP
+    // -t stands for --tmp-folder in the indexer.
+    addOption(parser, ArgParseOption("", "threads", "Specify the number of threads to use.", ArgParseOption::INTEGER));
+    setMinValue(parser, "threads", "1");
+    setMaxValue(parser, "threads", "2048");
+    setDefaultValue(parser, "threads", options.threadsCount);
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -153,8 +272,14 @@ parseCommandLine(Options & options, ArgumentParser & parser, int argc, char cons
     // Parse verbose output option.
     getOptionValue(options.verbose, parser, "verbose");
 
-    // Parse contigs input file.
-    getArgumentValue(options.genomeFile, parser, 0);
+    // Parse contigs input files.
+    for (unsigned fileId = 0; fileId < getArgumentValueCount(parser, 0); ++fileId)
+    {
+        getArgumentValue(options.genomeFile, parser, 0, fileId);
+        appendValue(options.genomeFiles, options.genomeFile);
+    }
+    options.genomeFile = options.genomeFiles[0];
+    getOptionValue(options.genomeAppend, parser, "append");
 
     // Parse contigs index prefix.
     getIndexPrefix(options, parser);
@@ -162,24 +287,218 @@ parseCommandLine(Options & options, ArgumentParser & parser, int argc, char cons
     // Parse tmp folder.
     getTmpFolder(options, parser);
 
+    // Parse index options.
+    getIndexType(options, parser);
+    getOptionValue(options.indexSampling, parser, "sampling");
+    getOptionValue(options.indexBidirectional, parser, "bidirectional");
+    getOptionValue(options.indexCompressed, parser, "compressed");
+    getOptionValue(options.indexDoubleStranded, parser, "double-stranded");
+    getOptionValue(options.indexShards, parser, "shards");
+    getOptionValue(options.indexKmers, parser, "kmers");
+
+    // The q-gram length selects the q-gram index.
+    if (options.indexKmers > 0)
+        options.genomeIndexType = QGRAM_INDEX;
+    else if (options.genomeIndexType == QGRAM_INDEX)
+        options.indexKmers = 12;
+    getOptionValue(options.indexRepeats, parser, "repeats");
+    getOptionValue(options.repeatsThreshold, parser, "repeats-threshold");
+
+    // Parse performance options.
+    getOptionValue(options.maxMemory, parser, "max-memory");
+
+#ifdef _OPENMP
+    getOptionValue(options.threadsCount, parser, "threads");
+#endif
+
     return seqan::ArgumentParser::PARSE_OK;
 }
 
+// ----------------------------------------------------------------------------
+// Function _checkIndexOption()
+// ----------------------------------------------------------------------------
+// Throws if an option given on the command line differs from the configuration of the index to append to.
+
+template <typename TValue>
+void _checkIndexOption(ArgumentParser const & parser, char const * name, TValue optionValue, TValue headerValue)
+{
+    if (isSet(parser, name) && optionValue != headerValue)
+        throw RuntimeError(std::string("The option --") + name + " does not match the reference index to append to.");
+}
+
+// ----------------------------------------------------------------------------
+// Function openIndexHeader()
+// ----------------------------------------------------------------------------
+// Reads the configuration of the index to append to, the appended shard is built alike.
+
+void openIndexHeader(Options & options, ArgumentParser const & parser)
+{
+    IndexHeader header;
+
+    if (!open(header, toCString(options.genomeIndexFile)))
+        throw RuntimeError("Error while opening reference index header.");
+
+    if (header.version != IndexHeader::VERSION)
+        throw RuntimeError("The reference index was built by an earlier version of yara_indexer. Rebuild it.");
+
+    _checkIndexOption(parser, "sampling", options.indexSampling, header.sampling);
+    _checkIndexOption(parser, "bidirectional", options.indexBidirectional, header.bidirectional);
+    _checkIndexOption(parser, "compressed", options.indexCompressed, header.compressed);
+    _checkIndexOption(parser, "double-stranded", options.indexDoubleStranded, header.strands == 2);
+    _checkIndexOption(parser, "index", options.genomeIndexType == QGRAM_INDEX, header.kmers > 0);
+    _checkIndexOption(parser, "kmers", options.indexKmers, header.kmers);
+    _checkIndexOption(parser, "repeats", options.indexRepeats, header.repeats);
+
+    options.indexSampling = header.sampling;
+    options.indexBidirectional = header.bidirectional;
+    options.indexLarge = header.large;
+    options.indexCompressed = header.compressed;
+    options.indexDoubleStranded = header.strands == 2;
+    options.indexKmers = header.kmers;
+    options.genomeIndexType = (header.kmers > 0) ? QGRAM_INDEX : FM_INDEX;
+    options.indexRepeats = header.repeats;
+    options.shardRepeatsThreshold = header.repeatsThreshold;
+
+    if (header.repeats > 0 && header.repeatsThreshold == 0)
+        throw RuntimeError("The reference index does not record its frequent k-mers threshold. Rebuild it.");
+}
+
+// ----------------------------------------------------------------------------
+// Function configureThreads()
+// ----------------------------------------------------------------------------
+// Sets the number of threads that OpenMP can spawn.
+
+void configureThreads(Options const & options)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(options.threadsCount);
+#endif
+
+    if (options.verbose)
+        std::cout << "Threads count:\t\t\t" << omp_get_max_threads() << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// Function getContigsMemory()
+// ----------------------------------------------------------------------------
+// Returns the memory taken by the packed contigs, which are kept while building all but the last shard.
+
+template <typename TContigs>
+__uint64 getContigsMemory(TContigs const & contigs)
+{
+    typedef typename TContigs::TContigValue TContigValue;
+
+    return (__uint64)lengthSum(contigs.seqs) * BitsPerValue<TContigValue>::VALUE / 8;
+}
+
+// ----------------------------------------------------------------------------
+// Function createIndex()
+// ----------------------------------------------------------------------------
+// Builds the SA and LF fibres; within a memory budget the suffix array is sorted in parts on disk.
+// The budget must hold the contigs and the index under construction, the parts take what is left.
+
+template <typename TIndex>
+void createIndex(TIndex & index, Options const & options, __uint64 contigsMemory)
+{
+    typedef typename Fibre<TIndex, FibreText>::Type         TText;
+    typedef typename SAValue<TText>::Type                   TSAValue;
+    typedef typename Value<typename Value<TText>::Type>::Type TAlphabet;
+
+    if (options.maxMemory > 0)
+    {
+        __uint64 maxMemory = (__uint64)options.maxMemory << 20;
+        __uint64 textMemory = contigsMemory + lengthSum(indexText(index)) * sizeof(TAlphabet);
+
+        if (maxMemory <= contigsMemory + getIndexMemory(index, options.indexSampling))
+            throw RuntimeError("Insufficient memory budget to index the reference. Specify a bigger --max-memory.");
+
+        // Shrink the parts until they fit together with the buckets and the pages of all part files.
+        __uint64 partLength = (maxMemory - textMemory) / sizeof(TSAValue);
+        while (partLength > 0 && textMemory + getSuffixArrayMemory(index, partLength) > maxMemory)
+            partLength -= partLength / 16 + 1;
+
+        if (partLength == 0)
+            throw RuntimeError("Insufficient memory budget to index the reference. Specify a bigger --max-memory.");
+
+        SortingProgress progress(options.verbose);
+        indexCreate(index, FibreSALF(), External<>(), partLength, progress, options.indexSampling);
+    }
+    else if (options.threadsCount > 1)
+    {
+        indexCreate(index, FibreSALF(), Parallel(), options.indexSampling);
+    }
+    else
+    {
+        indexCreate(index, FibreSALF(), Serial(), options.indexSampling);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function openGenome()
+// ----------------------------------------------------------------------------
+// Opens the contigs of the index to append to, the contigs loaded next form one more shard.
+
+template <typename TIndexConfig, typename TSpec>
+void openGenome(Indexer<TIndexConfig, TSpec> & me, Options const & options)
+{
+    if (options.verbose)
+        std::cout << "Opening reference index:\t\t" << std::flush;
+
+    IndexHeader header;
+
+    start(me.timer);
+    try
+    {
+        if (!open(header, toCString(options.genomeIndexFile)))
+            throw RuntimeError("Error while opening reference index header.");
+
+        if (!open(me.contigs, toCString(options.genomeIndexFile), OPEN_RDONLY))
+            throw RuntimeError("Error while opening reference file.");
+
+        if (options.indexRepeats > 0 && !open(me.repeats, toCString(options.genomeIndexFile), options.indexRepeats, OPEN_RDONLY))
+            throw RuntimeError("Error while opening reference frequent k-mers table.");
+    }
+    catch (BadAlloc const & /* e */)
+    {
+        throw RuntimeError("Insufficient memory to load the reference.");
+    }
+    stop(me.timer);
+
+    // An unsharded index becomes the first shard.
+    me.shards = header.shards;
+    if (empty(me.shards))
+        appendValue(me.shards, 0u);
+    appendValue(me.shards, static_cast<__uint32>(length(me.contigs.seqs)));
+
+    if (options.verbose)
+        std::cout << me.timer << std::endl;
+}
+
 // ----------------------------------------------------------------------------
 // Function loadGenome()
 // ----------------------------------------------------------------------------
+// Appends the contigs of all reference files, in the given order.
 
-template <typename TIndexSpec, typename TSpec>
-void loadGenome(Indexer<TIndexSpec, TSpec> & me, Options const & options)
+template <typename TIndexConfig, typename TSpec>
+void loadGenome(Indexer<TIndexConfig, TSpec> & me, Options const & options)
 {
+    typedef typename Indexer<TIndexConfig, TSpec>::TIndex           TIndex;
+    typedef typename Indexer<TIndexConfig, TSpec>::TContigsLoader   TContigsLoader;
+    typedef typename Size<TIndex>::Type                             TIndexSize;
+    typedef typename TIndexConfig::TSizeSpec                        TSizeSpec;
+
     if (options.verbose)
         std::cout << "Loading reference:\t\t\t" << std::flush;
 
     start(me.timer);
-    open(me.contigsLoader, options.genomeFile);
     try
     {
-        load(me.contigs, me.contigsLoader);
+        for (unsigned fileId = 0; fileId < length(options.genomeFiles); ++fileId)
+        {
+            TContigsLoader contigsLoader;
+            open(contigsLoader, options.genomeFiles[fileId]);
+            load(me.contigs, contigsLoader);
+        }
     }
     catch (BadAlloc const & /* e */)
     {
@@ -187,12 +506,18 @@ void loadGenome(Indexer<TIndexSpec, TSpec> & me, Options const & options)
     }
     stop(me.timer);
 
-    if (length(me.contigs.seqs) > YaraLimits<TSpec>::CONTIG_ID)
+    // A double-stranded index contains each contig twice.
+    __uint64 strands = options.indexDoubleStranded ? 2 : 1;
+
+    if (strands * length(me.contigs.seqs) > YaraLimits<TSizeSpec>::CONTIG_ID)
         throw RuntimeError("Maximum number of contigs exceeded.");
 
-    if (maxLength(me.contigs.seqs) > YaraLimits<TSpec>::CONTIG_SIZE)
+    if (maxLength(me.contigs.seqs) > YaraLimits<TSizeSpec>::CONTIG_SIZE)
         throw RuntimeError("Maximum contig length exceeded.");
 
+    if (strands * (lengthSum(me.contigs.seqs) + length(me.contigs.seqs)) > MaxValue<TIndexSize>::VALUE)
+        throw RuntimeError("Maximum reference length exceeded.");
+
     if (options.verbose)
         std::cout << me.timer << std::endl;
 }
@@ -201,8 +526,8 @@ void loadGenome(Indexer<TIndexSpec, TSpec> & me, Options const & options)
 // Function saveGenome()
 // ----------------------------------------------------------------------------
 
-template <typename TIndexSpec, typename TSpec>
-void saveGenome(Indexer<TIndexSpec, TSpec> & me, Options const & options)
+template <typename TIndexConfig, typename TSpec>
+void saveGenome(Indexer<TIndexConfig, TSpec> & me, Options const & options)
 {
     if (options.verbose)
         std::cout << "Dumping reference:\t\t\t" << std::flush;
@@ -217,38 +542,194 @@ void saveGenome(Indexer<TIndexSpec, TSpec> & me, Options const & options)
 }
 
 // ----------------------------------------------------------------------------
-// Function buildIndex()
+// Function saveMask()
 // ----------------------------------------------------------------------------
+// Dumps the runs of Ns, which are then replaced by random bases in the index.
 
-template <typename TIndexSpec, typename TSpec>
-void buildIndex(Indexer<TIndexSpec, TSpec> & me, Options const & options)
+template <typename TIndexConfig, typename TSpec>
+void saveMask(Indexer<TIndexConfig, TSpec> & me, Options const & options)
 {
-    typedef typename Indexer<TIndexSpec, TSpec>::TIndex TIndex;
+    if (options.verbose)
+        std::cout << "Dumping reference mask:\t\t\t" << std::flush;
+
+    ContigsMask mask;
+
+    start(me.timer);
+    build(mask, me.contigs);
+    if (!save(mask, toCString(options.genomeIndexFile)))
+        throw RuntimeError("Error while dumping reference mask file.");
+    stop(me.timer);
 
     if (options.verbose)
-        std::cout << "Building reference index:\t\t" << std::flush;
+        std::cout << me.timer << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// Function partitionGenome()
+// ----------------------------------------------------------------------------
+// Splits the contigs into consecutive shards of about the same length.
+
+template <typename TIndexConfig, typename TSpec>
+void partitionGenome(Indexer<TIndexConfig, TSpec> & me, Options const & options)
+{
+    __uint64 contigsCount = length(me.contigs.seqs);
+    __uint64 contigsLength = lengthSum(me.contigs.seqs);
+    __uint64 shardsCount = options.indexShards;
+    __uint64 shardsLength = 0;
+
+    clear(me.shards);
+
+    if (shardsCount <= 1) return;
+
+    if (shardsCount > contigsCount)
+        throw RuntimeError("The number of shards exceeds the number of contigs.");
+
+    appendValue(me.shards, 0u);
+
+    for (__uint64 contigId = 1; contigId < contigsCount && length(me.shards) < shardsCount; ++contigId)
+    {
+        shardsLength += length(me.contigs.seqs[contigId - 1]);
+
+        // Start a new shard once the previous ones cover their share, or when each remaining contig needs its own.
+        if (shardsLength * shardsCount >= contigsLength * length(me.shards) ||
+            contigsCount - contigId == shardsCount - length(me.shards))
+            appendValue(me.shards, contigId);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function setShardText()
+// ----------------------------------------------------------------------------
+// Assigns the contigs of one shard to the index text.
+// A double-stranded index appends their reverse complements, which are the same whether the contigs are reversed or not.
+// This assignment implicitly converts the contigs to the index contigs.
+
+template <typename TIndex, typename TIndexConfig, typename TSpec>
+void setShardText(TIndex & index, Indexer<TIndexConfig, TSpec> const & me, Options const & options, unsigned shardId)
+{
+    typedef typename Fibre<TIndex, FibreText>::Type     TText;
+    typedef typename Value<TText>::Type                 TTextSeq;
+
+    Pair<__uint32> contigs = getShardContigs(me.shards, shardId, length(me.contigs.seqs));
+
+    TText text;
+    for (__uint32 contigId = contigs.i1; contigId < contigs.i2; ++contigId)
+        appendValue(text, me.contigs.seqs[contigId]);
+
+    if (options.indexDoubleStranded)
+    {
+        TTextSeq revContig;
+        for (__uint32 contigId = contigs.i1; contigId < contigs.i2; ++contigId)
+        {
+            revContig = me.contigs.seqs[contigId];
+            reverseComplement(revContig);
+            appendValue(text, revContig);
+        }
+    }
+
+    setValue(index.text, text);
+}
+
+// ----------------------------------------------------------------------------
+// Function getShardRepeatsThreshold()
+// ----------------------------------------------------------------------------
+// Each shard keeps the k-mers occurring at least its share of the threshold; appended shards keep the share of the
+// existing ones.
+
+template <typename TIndexConfig, typename TSpec>
+unsigned getShardRepeatsThreshold(Indexer<TIndexConfig, TSpec> const & me, Options const & options)
+{
+    if (options.genomeAppend)
+        return options.shardRepeatsThreshold;
+
+    unsigned shardsCount = getShardsCount(me.shards);
+
+    return (options.repeatsThreshold + shardsCount - 1) / shardsCount;
+}
+
+// ----------------------------------------------------------------------------
+// Function buildReverseIndex()
+// ----------------------------------------------------------------------------
+// Builds and dumps the LF fibre of the forward contigs, the reversed half of the bidirectional index.
+
+template <typename TIndexConfig, typename TSpec>
+void buildReverseIndex(Indexer<TIndexConfig, TSpec> & me, Options const & options, unsigned shardId)
+{
+    typedef typename Indexer<TIndexConfig, TSpec>::TIndex TIndex;
 
     start(me.timer);
 
     try
     {
-        // Remove Ns from contigs.
-        removeNs(me.contigs);
-
-        // IndexFM is built on the reversed contigs.
-        reverse(me.contigs);
+        TIndex revIndex;
 
         // Set the index text.
-        // NOTE(esiragusa): this assignment implicitly assigns and converts the contigs to the index contigs.
-        setValue(me.index.text, me.contigs.seqs);
+        setShardText(revIndex, me, options, shardId);
 
-        // Clears the contigs.
-        // NOTE(esiragusa): the index now owns its own contigs.
-        shrinkToFit(me.contigs.seqs);
+        // Build the SA and LF fibres.
+        createIndex(revIndex, options, getContigsMemory(me.contigs));
 
-        // Iterator instantiation calls automatic index construction.
-        typename Iterator<TIndex, TopDown<> >::Type it(me.index);
-        ignoreUnusedVariableWarning(it);
+        // Only the LF fibre is needed to search.
+        CharString name = getShardFile(shardId, options.genomeIndexFile);
+        append(name, ".rlf");
+        if (!save(indexLF(revIndex), toCString(name)))
+            throw RuntimeError("Error while dumping reverse genome index file.");
+    }
+    catch (BadAlloc const & /* e */)
+    {
+        throw RuntimeError("Insufficient memory to index the reference.");
+    }
+    catch (IOError const & /* e */)
+    {
+        throw RuntimeError("Insufficient disk space to index the reference. \
+                            Specify a bigger temporary folder using the options --tmp-folder.");
+    }
+
+    stop(me.timer);
+
+    if (options.verbose)
+        std::cout << "Building reverse reference index:\t" << me.timer << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// Function buildIndex()
+// ----------------------------------------------------------------------------
+
+template <typename TIndexConfig, typename TSpec>
+void buildIndex(Indexer<TIndexConfig, TSpec> & me, Options const & options, unsigned shardId)
+{
+    start(me.timer);
+
+    try
+    {
+        // Set the index text.
+        // The contigs have already been reversed, IndexFM is built on the reversed contigs.
+        clear(me.index);
+        setShardText(me.index, me, options, shardId);
+
+        // Clears the contigs after the last shard.
+        // The index now owns its own contigs, the reference has already been dumped.
+        if (shardId + 1 == getShardsCount(me.shards))
+        {
+            clear(me.contigs);
+            shrinkToFit(me.contigs.seqs);
+        }
+
+        // Build the SA and LF fibres.
+        createIndex(me.index, options, getContigsMemory(me.contigs));
+
+        // Build the q-grams table.
+        if (options.genomeIndexType == QGRAM_INDEX)
+            build(me.kmers, me.index, options.indexKmers);
+
+        // Add the frequent k-mers of this shard.
+        // Each shard lowers the threshold, a k-mer frequent in the reference is frequent in some shard.
+        if (options.indexRepeats > 0)
+        {
+            typename Indexer<TIndexConfig, TSpec>::TRepeatsTable shardRepeats;
+            build(shardRepeats, me.index, options.indexRepeats, getShardRepeatsThreshold(me, options));
+            merge(me.repeats, shardRepeats);
+        }
     }
     catch (BadAlloc const & /* e */)
     {
@@ -265,22 +746,78 @@ void buildIndex(Indexer<TIndexSpec, TSpec> & me, Options const & options)
     stop(me.timer);
 
     if (options.verbose)
-        std::cout << me.timer << std::endl;
+        std::cout << "Building reference index:\t\t" << me.timer << std::endl;
 }
 
 // ----------------------------------------------------------------------------
 // Function saveIndex()
 // ----------------------------------------------------------------------------
 
-template <typename TIndexSpec, typename TSpec>
-void saveIndex(Indexer<TIndexSpec, TSpec> & me, Options const & options)
+template <typename TIndexConfig, typename TSpec>
+void saveIndex(Indexer<TIndexConfig, TSpec> & me, Options const & options, unsigned shardId)
 {
     if (options.verbose)
         std::cout << "Dumping genome index:\t\t" << std::flush;
 
+    CharString name = getShardFile(shardId, options.genomeIndexFile);
+
     start(me.timer);
-    if (!save(me.index, toCString(options.genomeIndexFile)))
+    if (!save(me.index, toCString(name)))
         throw RuntimeError("Error while dumping genome index file.");
+    if (!empty(me.kmers) && !save(me.kmers, toCString(name)))
+        throw RuntimeError("Error while dumping genome index k-mers table.");
+    stop(me.timer);
+
+    if (options.verbose)
+        std::cout << me.timer << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// Function saveRepeats()
+// ----------------------------------------------------------------------------
+
+template <typename TIndexConfig, typename TSpec>
+void saveRepeats(Indexer<TIndexConfig, TSpec> & me, Options const & options)
+{
+    if (options.verbose)
+    {
+        std::cout << "Frequent k-mers count:\t\t\t" << length(me.repeats.repeats) << std::endl;
+        std::cout << "Dumping frequent k-mers table:\t\t" << std::flush;
+    }
+
+    start(me.timer);
+    if (!save(me.repeats, toCString(options.genomeIndexFile)))
+        throw RuntimeError("Error while dumping frequent k-mers table.");
+    stop(me.timer);
+
+    if (options.verbose)
+        std::cout << me.timer << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+// Function saveHeader()
+// ----------------------------------------------------------------------------
+
+template <typename TIndexConfig, typename TSpec>
+void saveHeader(Indexer<TIndexConfig, TSpec> & me, Options const & options)
+{
+    if (options.verbose)
+        std::cout << "Dumping genome index header:\t\t" << std::flush;
+
+    IndexHeader header;
+    header.sampling = options.indexSampling;
+    header.bidirectional = options.indexBidirectional;
+    header.large = IsSameType<typename TIndexConfig::TSizeSpec, LargeContigs>::VALUE;
+    header.compressed = IsSameType<typename TIndexConfig::TProfile, CompressedIndex>::VALUE;
+    header.strands = options.indexDoubleStranded ? 2 : 1;
+    header.kmers = options.indexKmers;
+    header.repeats = options.indexRepeats;
+    header.repeatsThreshold = (options.indexRepeats > 0) ? getShardRepeatsThreshold(me, options) : 0;
+    header.shards = me.shards;
+
+    start(me.timer);
+    if (!save(header, toCString(options.genomeIndexFile)))
+        throw RuntimeError("Error while dumping genome index header.");
     stop(me.timer);
 
     if (options.verbose)
@@ -291,13 +828,107 @@ void saveIndex(Indexer<TIndexSpec, TSpec> & me, Options const & options)
 // Function runIndexer()
 // ----------------------------------------------------------------------------
 
-template <typename TIndexSpec, typename TSpec>
-void runIndexer(Indexer<TIndexSpec, TSpec> & me, Options const & options)
+template <typename TIndexConfig, typename TSpec>
+void runIndexer(Indexer<TIndexConfig, TSpec> & me, Options const & options)
 {
+    configureThreads(options);
+
+    // Only the shards of the new contigs are built.
+    unsigned shardsBegin = 0;
+
+    if (options.genomeAppend)
+    {
+        openGenome(me, options);
+        shardsBegin = length(me.shards) - 1;
+    }
+
     loadGenome(me, options);
+
+    if (options.genomeAppend && back(me.shards) == length(me.contigs.seqs))
+        throw RuntimeError("The reference files contain no contigs to append.");
+
+    // Each shard keeps the k-mers occurring at least its share of the threshold.
+    if (options.indexRepeats > 0 && !options.genomeAppend && options.repeatsThreshold < options.indexShards)
+        throw RuntimeError("The frequent k-mers threshold is smaller than the number of shards.");
+
     saveGenome(me, options);
-    buildIndex(me, options);
-    saveIndex(me, options);
+    saveMask(me, options);
+
+    if (!options.genomeAppend)
+        partitionGenome(me, options);
+
+    // Remove Ns from contigs.
+    removeNs(me.contigs);
+
+    if (options.indexBidirectional)
+        for (unsigned shardId = shardsBegin; shardId < getShardsCount(me.shards); ++shardId)
+            buildReverseIndex(me, options, shardId);
+
+    // IndexFM is built on the reversed contigs.
+    reverse(me.contigs);
+
+    for (unsigned shardId = shardsBegin; shardId < getShardsCount(me.shards); ++shardId)
+    {
+        buildIndex(me, options, shardId);
+        saveIndex(me, options, shardId);
+    }
+
+    if (options.indexRepeats > 0)
+        saveRepeats(me, options);
+
+    saveHeader(me, options);
+}
+
+// ----------------------------------------------------------------------------
+// Function spawnIndexer()
+// ----------------------------------------------------------------------------
+
+template <typename TIndexConfig>
+void spawnIndexer(Options const & options, TIndexConfig const & /* tag */)
+{
+    Indexer<TIndexConfig, YaraStringSpec> indexer;
+    runIndexer(indexer, options);
+}
+
+// ----------------------------------------------------------------------------
+// Function configureProfile()
+// ----------------------------------------------------------------------------
+
+template <typename TSizeSpec>
+void configureProfile(Options const & options)
+{
+    if (options.indexCompressed)
+        spawnIndexer(options, YaraFMIndexConfig<TSizeSpec, CompressedIndex>());
+    else
+        spawnIndexer(options, YaraFMIndexConfig<TSizeSpec, void>());
+}
+
+// ----------------------------------------------------------------------------
+// Function configureIndexer()
+// ----------------------------------------------------------------------------
+// The FASTA files size bounds the reference length, so 64-bit positions are
+// selected only when 32-bit positions could overflow. Appended shards keep the positions of their index.
+
+void configureIndexer(Options const & options)
+{
+    __uint64 filesSize = 0;
+
+    for (unsigned fileId = 0; fileId < length(options.genomeFiles); ++fileId)
+    {
+        std::ifstream file(toCString(options.genomeFiles[fileId]), std::ios::binary | std::ios::ate);
+
+        if (!file.is_open())
+            throw RuntimeError("Error while opening the reference file.");
+
+        filesSize += file.tellg();
+    }
+
+    __uint64 strands = options.indexDoubleStranded ? 2 : 1;
+
+    if (options.genomeAppend ? options.indexLarge : (strands * filesSize > MaxValue<__uint32>::VALUE))
+        configureProfile<LargeContigs>(options);
+    else
+        configureProfile<void>(options);
 }
 
 // ----------------------------------------------------------------------------
@@ -317,8 +948,10 @@ int main(int argc, char const ** argv)
 
     try
     {
-        Indexer<YaraIndexSpec, YaraStringSpec> indexer;
-        runIndexer(indexer, options);
+        if (options.genomeAppend)
+            openIndexHeader(options, parser);
+
+        configureIndexer(options);
     }
     catch (BadAlloc const & /* e */)
     {
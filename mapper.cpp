@@ -44,6 +44,12 @@ struct Options;
 // Prerequisites
 // ============================================================================
 
+// ----------------------------------------------------------------------------
+// STL headers
+// ----------------------------------------------------------------------------
+
+#include <cstdio>
+
 // ----------------------------------------------------------------------------
 // SeqAn headers
 // ----------------------------------------------------------------------------
@@ -69,13 +75,20 @@ struct Options;
 
 #include "misc_timer.h"
 #include "misc_types.h"
+#include "index_rank.h"
 #include "index_fm.h"
+#include "index_kmers.h"
+#include "index_repeats.h"
+#include "index_header.h"
 #include "bits_hits.h"
 #include "bits_context.h"
 #include "bits_matches.h"
 #include "bits_seeds.h"
 #include "find_verifier.h"
 #include "find_extender.h"
+#include "find_schemes.h"
+#include "find_kmers.h"
+#include "find_batched.h"
 #include "mapper_collector.h"
 #include "mapper_classifier.h"
 #include "mapper_ranker.h"
@@ -119,7 +132,7 @@ void setupArgumentParser(ArgumentParser & parser, Options const & options)
 
     addArgument(parser, ArgParseArgument(ArgParseArgument::INPUTFILE, "READS", true));
     setValidValues(parser, 1, options.readsExtensionList);
-    setHelpText(parser, 1, "Either one single-end or two paired-end / mate-pairs read files.");
+    setHelpText(parser, 1, "Either one single-end or two paired-end / mate-pairs read files, or - for single-end reads from the standard input.");
 
     addOption(parser, ArgParseOption("v", "verbose", "Displays global statistics."));
     addOption(parser, ArgParseOption("vv", "vverbose", "Displays diagnostic output per batch of reads."));
@@ -134,6 +147,9 @@ void setupArgumentParser(ArgumentParser & parser, Options const & options)
 
     setOutputFile(parser, options);
 
+    addOption(parser, ArgParseOption("of", "output-format", "Specify the standard output format. An output file must match it by extension. Default: SAM.", ArgParseOption::STRING));
+    setValidValues(parser, "output-format", options.outputFormatList);
+
     addOption(parser, ArgParseOption("os", "output-secondary", "Output suboptimal alignments as secondary alignments. \
                                                                 Default: output suboptimal alignments inside XA tag."));
 
@@ -192,6 +208,16 @@ void setupArgumentParser(ArgumentParser & parser, Options const & options)
     setMinValue(parser, "reads-batch", "1000");
     setMaxValue(parser, "reads-batch", "1000000");
     setDefaultValue(parser, "reads-batch", options.readsCount);
+
+    addOption(parser, ArgParseOption("rp", "reads-prefetch", "Number of batches of reads to load ahead.", ArgParseOption::INTEGER));
+    setMinValue(parser, "reads-prefetch", "1");
+    setMaxValue(parser, "reads-prefetch", "64");
+    setDefaultValue(parser, "reads-prefetch", options.readsPrefetch);
+
+    addOption(parser, ArgParseOption("rl", "reads-loaders", "Number of threads loading batches of reads.", ArgParseOption::INTEGER));
+    setMinValue(parser, "reads-loaders", "1");
+    setMaxValue(parser, "reads-loaders", "64");
+    setDefaultValue(parser, "reads-loaders", options.readsLoaders);
 }
 
 // ----------------------------------------------------------------------------
@@ -225,14 +251,51 @@ parseCommandLine(Options & options, ArgumentParser & parser, int argc, char cons
         return ArgumentParser::PARSE_ERROR;
     }
 
-    // Parse reads input type.
-    getInputType(options, options.readsFile.i1);
+    // Parse reads input type, only regular Fasta and Fastq files are mapped, the other files are streamed.
+    if (options.readsFile.i1 == "-" || options.readsFile.i2 == "-")
+    {
+        if (!options.singleEnd)
+        {
+            std::cerr << getAppName(parser) << ": Paired-end reads cannot be read from the standard input." << std::endl;
+            return ArgumentParser::PARSE_ERROR;
+        }
+
+        options.inputType = STREAM;
+    }
+    else
+    {
+        getInputType(options, options.readsFile.i1);
+
+        if (options.inputType == PLAIN &&
+            !(isRegularFile(options.readsFile.i1) && isMappable(options.readsFile.i1) &&
+              (options.singleEnd || (isRegularFile(options.readsFile.i2) && isMappable(options.readsFile.i2)))))
+            options.inputType = STREAM;
+    }
 
     // Parse output file.
     getOutputFile(options.outputFile, options, parser, options.readsFile.i1, "");
 
-    // Parse output format.
-    getOutputFormat(options, options.outputFile);
+    // Parse output format, an output file determines it from its extension.
+    if (options.outputFile != "-")
+    {
+        getOutputFormat(options, options.outputFile);
+
+        if (isSet(parser, "output-format"))
+        {
+            OutputFormat outputFormat;
+            getOptionValue(outputFormat, parser, "output-format", options.outputFormatList);
+
+            if (outputFormat != options.outputFormat)
+            {
+                std::cerr << getAppName(parser) << ": The output format does not match the output file extension." << std::endl;
+                return ArgumentParser::PARSE_ERROR;
+            }
+        }
+    }
+    else if (isSet(parser, "output-format"))
+    {
+        getOptionValue(options.outputFormat, parser, "output-format", options.outputFormatList);
+    }
     getOptionValue(options.outputSecondary, parser, "output-secondary");
     options.outputHeader = !isSet(parser, "no-header");
 
@@ -266,6 +329,8 @@ parseCommandLine(Options & options, ArgumentParser & parser, int argc, char cons
 #endif
 
     getOptionValue(options.readsCount, parser, "reads-batch");
+    getOptionValue(options.readsPrefetch, parser, "reads-prefetch");
+    getOptionValue(options.readsLoaders, parser, "reads-loaders");
 
     if (isSet(parser, "verbose")) options.verbose = 1;
     if (isSet(parser, "vverbose")) options.verbose = 2;
@@ -284,6 +349,62 @@ parseCommandLine(Options & options, ArgumentParser & parser, int argc, char cons
     return seqan::ArgumentParser::PARSE_OK;
 }
 
+// ----------------------------------------------------------------------------
+// Function openIndexHeader()
+// ----------------------------------------------------------------------------
+// Reads the configuration of the reference index.
+
+void openIndexHeader(Options & options)
+{
+    IndexHeader header;
+
+    // Indices built without a header or in another format must be rebuilt.
+    if (!open(header, toCString(options.genomeIndexFile)) || header.version != IndexHeader::VERSION)
+        throw RuntimeError("The reference index was built by an earlier version of yara_indexer. Rebuild it.");
+
+    options.indexBidirectional = header.bidirectional;
+    options.indexLarge = header.large;
+    options.indexCompressed = header.compressed;
+    options.indexDoubleStranded = header.strands == 2;
+    options.indexKmers = header.kmers;
+    options.indexRepeats = header.repeats;
+    options.indexShards = header.shards;
+}
+
+// ----------------------------------------------------------------------------
+// Function configureProfile()
+// ----------------------------------------------------------------------------
+
+template <typename TSizeSpec, typename TExecSpace, typename TThreading, typename TInputType, typename TOutputFormat,
+          typename TSequencing, typename TStrategy>
+void configureProfile(Options const & options, TExecSpace const & execSpace, TThreading const & threading,
+                      TInputType const & inputType, TOutputFormat const & format, TSequencing const & sequencing,
+                      TStrategy const & strategy)
+{
+    if (options.indexCompressed)
+        spawnMapper(options, execSpace, threading, inputType, format, sequencing, strategy,
+                    YaraFMIndexConfig<TSizeSpec, CompressedIndex>());
+    else
+        spawnMapper(options, execSpace, threading, inputType, format, sequencing, strategy,
+                    YaraFMIndexConfig<TSizeSpec, void>());
+}
+
+// ----------------------------------------------------------------------------
+// Function configureIndex()
+// ----------------------------------------------------------------------------
+
+template <typename TExecSpace, typename TThreading, typename TInputType, typename TOutputFormat, typename TSequencing,
+          typename TStrategy>
+void configureIndex(Options const & options, TExecSpace const & execSpace, TThreading const & threading,
+                    TInputType const & inputType, TOutputFormat const & format, TSequencing const & sequencing,
+                    TStrategy const & strategy)
+{
+    if (options.indexLarge)
+        configureProfile<LargeContigs>(options, execSpace, threading, inputType, format, sequencing, strategy);
+    else
+        configureProfile<void>(options, execSpace, threading, inputType, format, sequencing, strategy);
+}
+
 // ----------------------------------------------------------------------------
 // Function configureAnchoring()
 // ----------------------------------------------------------------------------
@@ -309,16 +430,19 @@ void configureInputType(Options const & options, TExecSpace const & execSpace, T
     switch (options.inputType)
     {
     case PLAIN:
-        return spawnMapper(options, execSpace, threading, Nothing(), format, sequencing, strategy);
+        return configureIndex(options, execSpace, threading, MMap<>(), format, sequencing, strategy);
+
+    case STREAM:
+        return configureIndex(options, execSpace, threading, Nothing(), format, sequencing, strategy);
 
 #ifdef SEQAN_HAS_ZLIB
     case GZIP:
-        return spawnMapper(options, execSpace, threading, GZFile(), format, sequencing, strategy);
+        return configureIndex(options, execSpace, threading, GZFile(), format, sequencing, strategy);
 #endif
 
 #ifdef SEQAN_HAS_BZIP2
     case BZIP2:
-        return spawnMapper(options, execSpace, threading, BZ2File(), format, sequencing, strategy);
+        return configureIndex(options, execSpace, threading, BZ2File(), format, sequencing, strategy);
 #endif
 
     default:
@@ -431,8 +555,13 @@ int main(int argc, char const ** argv)
     if (res != seqan::ArgumentParser::PARSE_OK)
         return res == seqan::ArgumentParser::PARSE_ERROR;
 
+    // Diagnostic output goes to the standard error when the alignments go to the standard output.
+    if (options.outputFile == "-")
+        std::cout.rdbuf(std::cerr.rdbuf());
+
     try
     {
+        openIndexHeader(options);
         configureMapper(options);
     }
     catch (BadAlloc const & /* e */)
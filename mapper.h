@@ -53,6 +53,13 @@ struct Options
 
     CharString          genomeFile;
     CharString          genomeIndexFile;
+    bool                indexBidirectional;
+    bool                indexLarge;
+    bool                indexCompressed;
+    bool                indexDoubleStranded;
+    unsigned            indexKmers;
+    unsigned            indexRepeats;
+    String<__uint32>    indexShards;
 
     Pair<CharString>    readsFile;
     TList               readsFormatList;
@@ -79,6 +86,8 @@ struct Options
 //    bool                anchorOne;
 
     unsigned            readsCount;
+    unsigned            readsPrefetch;
+    unsigned            readsLoaders;
     bool                noCuda;
     unsigned            threadsCount;
     unsigned            hitsThreshold;
@@ -88,6 +97,12 @@ struct Options
     CharString          version;
 
     Options() :
+        indexBidirectional(false),
+        indexLarge(false),
+        indexCompressed(false),
+        indexDoubleStranded(false),
+        indexKmers(0),
+        indexRepeats(0),
         inputType(PLAIN),
         outputFormat(SAM),
         outputSecondary(false),
@@ -102,6 +117,8 @@ struct Options
         libraryOrientation(FWD_REV),
 //        anchorOne(false),
         readsCount(100000),
+        readsPrefetch(1),
+        readsLoaders(1),
         noCuda(false),
         threadsCount(1),
         hitsThreshold(300),
@@ -130,6 +147,7 @@ struct Options
         appendValue(readsExtensionList, "fasta.bz2");
         appendValue(readsExtensionList, "fa.bz2");
 #endif
+        appendValue(readsExtensionList, "-");
 
         appendValue(outputFormatList, "sam");
 #ifdef SEQAN_HAS_ZLIB
@@ -153,6 +171,7 @@ template <typename TExecSpace_      = ExecHost,
           typename TSequencing_     = SingleEnd,
           typename TStrategy_       = Strata,
 //          typename TAnchoring_      = Nothing,
+          typename TIndexConfig_    = YaraFMIndexConfig<>,
           unsigned BUCKETS_         = 3>
 struct ReadMapperConfig : public ContigsConfig<YaraStringSpec>, public ReadsConfig<void>
 {
@@ -163,6 +182,7 @@ struct ReadMapperConfig : public ContigsConfig<YaraStringSpec>, public ReadsConf
     typedef TSequencing_    TSequencing;
     typedef TStrategy_      TStrategy;
 //    typedef TAnchoring_     TAnchoring;
+    typedef TIndexConfig_   TIndexConfig;
 
     static const unsigned BUCKETS = BUCKETS_;
 };
@@ -186,16 +206,22 @@ struct MapperTraits
     typedef typename Value<TContigSeqs>::Type                       TContig;
     typedef typename StringSetPosition<TContigSeqs>::Type           TContigsPos;
 
-    typedef Index<YaraContigsFM, YaraIndexSpec>                     THostIndex;
+    typedef typename TConfig::TIndexConfig::TSizeSpec               TIndexSizeSpec;
+    typedef typename YaraIndexText<TIndexSizeSpec>::Type            TIndexText;
+    typedef FMIndex<void, typename TConfig::TIndexConfig>           TIndexSpec;
+    typedef Index<TIndexText, TIndexSpec>                           THostIndex;
     typedef typename Space<THostIndex, TExecSpace>::Type            TIndex;
     typedef typename Size<TIndex>::Type                             TIndexSize;
     typedef typename Fibre<TIndex, FibreSA>::Type                   TSA;
+    typedef typename Value<TSA>::Type                               TSAValue;
+    typedef ContigsBoundaries<TSAValue>                             TContigsBoundaries;
+    typedef typename Fibre<THostIndex, FibreLF>::Type               TRevLF;
+    typedef KmersTable<TIndexSize, YaraStringSpec>                  TKmersTable;
+    typedef RepeatsTable<YaraStringSpec>                            TRepeatsTable;
 
     typedef Reads<TSequencing, TConfig>                             TReads;
-    typedef Pair<TReads>                                            TReadsBuckets;
     typedef ReadsLoader<TSequencing, TConfig>                       TReadsLoader;
-    typedef LoadReadsWorker<TSequencing, TConfig>                   TLoadReadsWorker;
-    typedef Thread<TLoadReadsWorker>                                TReadsLoaderThread;
+    typedef ReadsRing<TSequencing, TConfig>                         TReadsRing;
     typedef typename TReads::TReadSeqs                              THostReadSeqs;
     typedef typename Space<THostReadSeqs, TExecSpace>::Type         TReadSeqs;
     typedef typename Value<TReadSeqs>::Type                         TReadSeq;
@@ -204,7 +230,7 @@ struct MapperTraits
 
     typedef typename TContigs::TContigNames                         TContigNames;
     typedef typename TContigs::TContigNamesCache                    TContigNamesCache;
-    typedef Stream<FileStream<File<MMap<> > > >                     TOutputStream;
+    typedef std::FILE *                                             TOutputStream;
     typedef BamIOContext<TContigNames, TContigNamesCache>           TOutputContext;
 
     typedef ReadsContext<TSpec, TConfig>                            TReadsContext;
@@ -221,7 +247,7 @@ struct MapperTraits
     typedef StringSet<TSeedsCount, Owner<ConcatDirect<> > >         TRanks;
     typedef Tuple<TRanks, TConfig::BUCKETS>                         TRanksBuckets;
 
-    typedef Match<void>                                             TMatch;
+    typedef Match<TIndexSizeSpec>                                   TMatch;
     typedef String<TMatch>                                          TMatches;
     typedef StringSet<TMatches, Segment<TMatches> >                 TMatchesSet;
     typedef ConcurrentAppender<TMatches>                            TMatchesAppender;
@@ -274,6 +300,22 @@ struct Stats
     {}
 };
 
+// ----------------------------------------------------------------------------
+// Class MapperShard
+// ----------------------------------------------------------------------------
+// The index of one shard, opened once and kept across the batches of reads.
+
+template <typename TSpec, typename TConfig = void>
+struct MapperShard
+{
+    typedef MapperTraits<TSpec, TConfig>    Traits;
+
+    typename Traits::TContigsBoundaries contigsBoundaries;
+    typename Traits::TIndex             index;
+    typename Traits::TRevLF             revLF;
+    typename Traits::TKmersTable        kmers;
+};
+
 // ----------------------------------------------------------------------------
 // Class Mapper
 // ----------------------------------------------------------------------------
@@ -288,12 +330,14 @@ struct Mapper
     Stats<double>                       stats;
 
     typename Traits::TContigs           contigs;
-    typename Traits::TIndex             index;
-    typename Traits::TReadsBuckets      readsBuckets;
+    ContigsMask                         contigsMask;
+    String<MapperShard<TSpec, TConfig> > shards;
+    MapperShard<TSpec, TConfig> *       shard;
+    typename Traits::TRepeatsTable      repeats;
+    bool                                repeatsWarned;
     typename Traits::TReads *           reads;
     typename Traits::TReadsLoader       readsLoader;
-    typename Traits::TLoadReadsWorker   loadReadsWorker;
-    typename Traits::TReadsLoaderThread readsLoaderThread;
+    typename Traits::TReadsRing         readsRing;
 
     typename Traits::TOutputStream      outputStream;
     typename Traits::TOutputContext     outputCtx;
@@ -312,10 +356,11 @@ struct Mapper
 
     Mapper(Options const & options) :
         options(options),
-        readsBuckets(),
-        reads(&readsBuckets.i1),
-        loadReadsWorker(&readsBuckets.i2, readsLoader, options.readsCount),
-        readsLoaderThread(loadReadsWorker),
+        shard(),
+        repeatsWarned(false),
+        reads(),
+        readsRing(readsLoader),
+        outputStream(),
         outputCtx(contigs.names, contigs.namesCache)
     {};
 };
@@ -343,7 +388,9 @@ inline TReadSeqSize getReadErrors(Options const & options, TReadSeqSize readSeqL
 template <typename TSpec, typename TConfig>
 inline void configureThreads(Mapper<TSpec, TConfig> & me)
 {
+#ifdef _OPENMP
     omp_set_num_threads(me.options.threadsCount);
+#endif
 
     if (me.options.verbose > 0)
         std::cout << "Threads count:\t\t\t" << omp_get_max_threads() << std::endl;
@@ -359,8 +406,17 @@ inline void loadGenome(Mapper<TSpec, TConfig> & me)
     start(me.timer);
     try
     {
-        if (!open(me.contigs, toCString(me.options.genomeIndexFile)))
+        if (!open(me.contigs, toCString(me.options.genomeIndexFile), OPEN_RDONLY))
             throw RuntimeError("Error while opening reference file.");
+
+        if (!open(me.contigsMask, toCString(me.options.genomeIndexFile), OPEN_RDONLY))
+            throw RuntimeError("Error while opening reference mask file.");
+
+        if (me.options.indexRepeats > 0)
+        {
+            if (!open(me.repeats, toCString(me.options.genomeIndexFile), me.options.indexRepeats, OPEN_RDONLY))
+                throw RuntimeError("Error while opening reference frequent k-mers table.");
+        }
     }
     catch (BadAlloc const & /* e */)
     {
@@ -376,6 +432,8 @@ inline void loadGenome(Mapper<TSpec, TConfig> & me)
 // ----------------------------------------------------------------------------
 // Function loadGenomeIndex()
 // ----------------------------------------------------------------------------
+// Opens the indices of all shards, whose suffix array values are localized within the contigs of their shard.
+// The indices are mapped, thus only the shard being searched needs to reside in the page cache.
 
 template <typename TSpec, typename TConfig>
 inline void loadGenomeIndex(Mapper<TSpec, TConfig> & me)
@@ -384,11 +442,17 @@ inline void loadGenomeIndex(Mapper<TSpec, TConfig> & me)
     cudaPrintFreeMemory();
 #endif
 
+    unsigned shardsCount = getShardsCount(me.options.indexShards);
+
     start(me.timer);
     try
     {
-        if (!open(me.index, toCString(me.options.genomeIndexFile)))
-            throw RuntimeError("Error while opening reference index file.");
+        resize(me.shards, shardsCount, Exact());
+
+        for (unsigned shardId = 0; shardId < shardsCount; ++shardId)
+            _loadGenomeIndexImpl(me, me.shards[shardId], shardId);
+
+        me.shard = &me.shards[0];
     }
     catch (BadAlloc const & /* e */)
     {
@@ -405,6 +469,33 @@ inline void loadGenomeIndex(Mapper<TSpec, TConfig> & me)
 #endif
 }
 
+template <typename TSpec, typename TConfig, typename TShard>
+inline void _loadGenomeIndexImpl(Mapper<TSpec, TConfig> & me, TShard & shard, unsigned shardId)
+{
+    CharString shardFile = getShardFile(shardId, me.options.genomeIndexFile);
+    Pair<__uint32> shardContigs = getShardContigs(me.options.indexShards, shardId, length(me.contigs.seqs));
+
+    if (!open(shard.index, toCString(shardFile), OPEN_RDONLY))
+        throw RuntimeError("Error while opening reference index file.");
+
+    if (me.options.indexBidirectional)
+    {
+        CharString name = shardFile;
+        append(name, ".rlf");
+        if (!open(shard.revLF, toCString(name), OPEN_RDONLY))
+            throw RuntimeError("Error while opening reverse reference index file.");
+    }
+
+    if (me.options.indexKmers > 0)
+    {
+        if (!open(shard.kmers, toCString(shardFile), OPEN_RDONLY) || shard.kmers.k != me.options.indexKmers)
+            throw RuntimeError("Error while opening reference index k-mers table.");
+    }
+
+    build(shard.contigsBoundaries, stringSetLimits(me.contigs.seqs), shardContigs.i1, shardContigs.i2,
+          me.options.indexDoubleStranded ? 2 : 1);
+}
+
 // ----------------------------------------------------------------------------
 // Function openReads()
 // ----------------------------------------------------------------------------
@@ -414,9 +505,11 @@ inline void openReads(Mapper<TSpec, TConfig> & me)
 {
     _openReadsImpl(me, typename TConfig::TSequencing());
 
-    // Preload one batch of reads.
+    // Preload the next batches of reads.
     if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
-        run(me.readsLoaderThread);
+        start(me.readsRing, me.options.readsCount, me.options.readsPrefetch + 1, me.options.readsLoaders);
+    else
+        start(me.readsRing, me.options.readsCount, 1u, 0u);
 }
 
 template <typename TSpec, typename TConfig, typename TSequencing>
@@ -441,19 +534,8 @@ inline void loadReads(Mapper<TSpec, TConfig> & me)
 {
     start(me.timer);
 
-    if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
-    {
-        // Wait next batch of reads.
-        waitFor(me.readsLoaderThread);
-
-        // Make next batch of reads the current one.
-        std::swap(me.reads, me.readsLoaderThread.worker.reads);
-    }
-    else
-    {
-        // Sync load.
-        load(value(me.reads), me.readsLoader, me.options.readsCount);
-    }
+    // Wait for the next batch of reads.
+    me.reads = &pop(me.readsRing);
 
     if (maxLength(me.reads->seqs, typename TConfig::TThreading()) > YaraLimits<TSpec>::READ_SIZE)
         throw RuntimeError("Maximum read length exceeded.");
@@ -471,10 +553,6 @@ inline void loadReads(Mapper<TSpec, TConfig> & me)
         std::cout << "Loading reads:\t\t\t" << me.timer << std::endl;
         std::cout << "Reads count:\t\t\t" << getReadsCount(me.reads->seqs) << std::endl;
     }
-
-    // Preload next batch of reads.
-    if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
-        run(me.readsLoaderThread);
 }
 
 // ----------------------------------------------------------------------------
@@ -496,7 +574,13 @@ inline void initOutput(Mapper<TSpec, TConfig> & me)
 {
     typedef MapperTraits<TSpec, TConfig>            TTraits;
 
-    if (!open(me.outputStream, toCString(me.options.outputFile), OPEN_RDWR | OPEN_CREATE))
+    // Open the output file, - stands for the standard output.
+    if (me.options.outputFile == "-")
+        me.outputStream = stdout;
+    else
+        me.outputStream = std::fopen(toCString(me.options.outputFile), "wb");
+
+    if (!me.outputStream)
         throw RuntimeError("Error while opening output file.");
 
     if (me.options.outputHeader)
@@ -511,6 +595,21 @@ inline void initOutput(Mapper<TSpec, TConfig> & me)
     }
 }
 
+// ----------------------------------------------------------------------------
+// Function closeOutput()
+// ----------------------------------------------------------------------------
+// Flushes the output, the standard output is left open.
+
+template <typename TSpec, typename TConfig>
+inline void closeOutput(Mapper<TSpec, TConfig> & me)
+{
+    int status = (me.outputStream == stdout) ? std::fflush(me.outputStream) : std::fclose(me.outputStream);
+    me.outputStream = NULL;
+
+    if (status != 0)
+        throw RuntimeError("Error while writing output file.");
+}
+
 // ----------------------------------------------------------------------------
 // Function initSeeds()
 // ----------------------------------------------------------------------------
@@ -588,7 +687,10 @@ inline void findSeeds(Mapper<TSpec, TConfig> & me, TBucketId bucketId)
     {
         // Estimate the number of hits.
         reserve(me.hits[bucketId], lengthSum(me.seeds[bucketId]) * Power<ERRORS, 2>::VALUE, Exact());
-        _findSeedsImpl(me, me.hits[bucketId], me.seeds[bucketId], ERRORS, HammingDistance());
+        if (me.options.indexBidirectional)
+            _findSeedsImpl(me, me.hits[bucketId], me.seeds[bucketId], ERRORS, SearchSchemes());
+        else
+            _findSeedsImpl(me, me.hits[bucketId], me.seeds[bucketId], ERRORS, HammingDistance());
     }
     else
     {
@@ -616,14 +718,97 @@ inline void _findSeedsImpl(Mapper<TSpec, TConfig> & me, THits & hits, TSeeds & s
     TAppender appender(hits);
     TDelegate delegate(appender);
 
-    // Find hits.
-    find(me.index, seeds, errors, delegate, Backtracking<TDistance>(), typename TConfig::TThreading());
+    // Find hits, the k-mers table replaces the first LF steps.
+    if (empty(me.shard->kmers))
+        find(me.shard->index, seeds, errors, delegate, Backtracking<TDistance>(), typename TConfig::TThreading());
+    else
+        find(me.shard->index, me.shard->kmers, seeds, errors, delegate, Backtracking<TDistance>(),
+             typename TConfig::TThreading());
+
+    // Sort the hits by seedId.
+    if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
+        sortHits(hits, typename TConfig::TThreading());
+}
+
+template <typename TSpec, typename TConfig, typename THits, typename TSeeds, typename TErrors>
+inline void _findSeedsImpl(Mapper<TSpec, TConfig> & me, THits & hits, TSeeds & seeds, TErrors /* errors */, Exact)
+{
+    typedef MapperTraits<TSpec, TConfig>            TTraits;
+    typedef FilterDelegate<TSpec, TTraits>          TDelegate;
+    typedef typename TTraits::THitsAppender         TAppender;
+
+    TAppender appender(hits);
+    TDelegate delegate(appender);
+
+    // Find hits by advancing batches of seeds in lockstep.
+    find(me.shard->index, me.shard->kmers, seeds, delegate, Batched(), typename TConfig::TThreading());
 
     // Sort the hits by seedId.
     if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
         sortHits(hits, typename TConfig::TThreading());
 }
 
+template <typename TSpec, typename TConfig, typename THits, typename TSeeds, typename TErrors>
+inline void _findSeedsImpl(Mapper<TSpec, TConfig> & me, THits & hits, TSeeds & seeds, TErrors errors, SearchSchemes)
+{
+    typedef MapperTraits<TSpec, TConfig>            TTraits;
+    typedef FilterDelegate<TSpec, TTraits>          TDelegate;
+    typedef typename TTraits::THitsAppender         TAppender;
+
+    TAppender appender(hits);
+    TDelegate delegate(appender);
+
+    // Find hits on the bidirectional index.
+    find(me.shard->index, me.shard->revLF, seeds, errors, delegate, SearchSchemes(), typename TConfig::TThreading());
+
+    // Sort the hits by seedId.
+    if (IsSameType<typename TConfig::TThreading, Parallel>::VALUE)
+        sortHits(hits, typename TConfig::TThreading());
+}
+
+// ----------------------------------------------------------------------------
+// Function classifyRepeats()
+// ----------------------------------------------------------------------------
+// Classifies the reads by hardness before searching their seeds.
+
+template <typename TSpec, typename TConfig, typename TReadSeqs>
+inline void classifyRepeats(Mapper<TSpec, TConfig> & me, TReadSeqs const & readSeqs)
+{
+    typedef MapperTraits<TSpec, TConfig>                TTraits;
+    typedef RepeatsClassifier<TSpec, TTraits>           TClassifier;
+
+    typedef typename Size<TReadSeqs const>::Type        TReadSeqId;
+    typedef typename Value<TReadSeqs const>::Type       TReadSeq;
+    typedef typename Size<TReadSeq>::Type               TReadSeqSize;
+
+    if (empty(me.repeats)) return;
+
+    // The frequent k-mers cannot bound the hits of exact seeds shorter than k, such reads are left unclassified.
+    if (!me.repeatsWarned)
+    {
+        for (TReadSeqId readSeqId = 0; readSeqId < length(readSeqs); ++readSeqId)
+        {
+            TReadSeqSize readSeqLength = length(readSeqs[readSeqId]);
+
+            if (readSeqLength / (getReadErrors(me.options, readSeqLength) + 1) < me.repeats.k)
+            {
+                std::cerr << "Warning: the exact seeds of some reads are shorter than the frequent k-mers "
+                             "of the reference index, these reads are classified after searching them." << std::endl;
+                me.repeatsWarned = true;
+                break;
+            }
+        }
+    }
+
+    start(me.timer);
+    TClassifier classifier(me.ctx, me.repeats, readSeqs, me.options);
+    stop(me.timer);
+    me.stats.classifyReads += getValue(me.timer);
+
+    if (me.options.verbose > 1)
+        std::cout << "Classification time:\t\t" << me.timer << std::endl;
+}
+
 // ----------------------------------------------------------------------------
 // Function classifyReads()
 // ----------------------------------------------------------------------------
@@ -716,9 +901,9 @@ inline void extendHits(Mapper<TSpec, TConfig> & me, TBucketId bucketId)
     typename TTraits::TMatchesAppender appender(me.matches);
 
     start(me.timer);
-    THitsExtender extender(me.ctx, appender, me.contigs.seqs,
+    THitsExtender extender(me.ctx, appender, me.contigs.seqs, me.shard->contigsBoundaries, me.contigsMask,
                            me.seeds[bucketId], me.hits[bucketId], me.ranks[bucketId], ERRORS,
-                           indexSA(me.index), me.options);
+                           indexSA(me.shard->index), me.options);
     stop(me.timer);
     me.stats.extendHits += getValue(me.timer);
 
@@ -984,11 +1169,34 @@ inline void writeMatches(Mapper<TSpec, TConfig> & me)
 // ----------------------------------------------------------------------------
 // Function mapReads()
 // ----------------------------------------------------------------------------
+// The matches of all shards are merged before ranking, thus the best stratum and the number of co-optimal
+// matches are the same as with a single index. The shards are mapped one at a time, only one shard index is
+// accessed at once and the page cache can evict the others. The reads context is kept across the shards,
+// thus the reads mapped in a shard are not seeded with more errors than their best match in the next shards.
 
 template <typename TSpec, typename TConfig>
 inline void mapReads(Mapper<TSpec, TConfig> & me)
 {
-    _mapReadsImpl(me, me.reads->seqs, typename TConfig::TStrategy());
+    initReadsContext(me, me.reads->seqs);
+    classifyRepeats(me, me.reads->seqs);
+
+    for (unsigned shardId = 0; shardId < length(me.shards); ++shardId)
+    {
+        me.shard = &me.shards[shardId];
+
+        if (shardId > 0)
+            clearMapped(me.ctx);
+
+        _mapReadsImpl(me, me.reads->seqs, typename TConfig::TStrategy());
+    }
+
+    aggregateMatches(me, me.reads->seqs);
+//    verifyMatches(me, me.reads->seqs);
+    rankMatches(me, me.reads->seqs);
+    alignMatches(me);
+    writeMatches(me);
+    clearMatches(me);
+    clearAlignments(me);
 }
 
 // ----------------------------------------------------------------------------
@@ -998,7 +1206,6 @@ inline void mapReads(Mapper<TSpec, TConfig> & me)
 template <typename TSpec, typename TConfig, typename TReadSeqs>
 inline void _mapReadsImpl(Mapper<TSpec, TConfig> & me, TReadSeqs & readSeqs, All)
 {
-    initReadsContext(me, readSeqs);
     initSeeds(me, readSeqs);
 
     collectSeeds<0>(me, readSeqs);
@@ -1017,13 +1224,6 @@ inline void _mapReadsImpl(Mapper<TSpec, TConfig> & me, TReadSeqs & readSeqs, All
     extendHits<2>(me, 2);
     clearSeeds(me);
     clearHits(me);
-    aggregateMatches(me, readSeqs);
-//    verifyMatches(me, readSeqs);
-    rankMatches(me, readSeqs);
-    alignMatches(me);
-    writeMatches(me);
-    clearMatches(me);
-    clearAlignments(me);
 }
 
 // ----------------------------------------------------------------------------
@@ -1033,7 +1233,6 @@ inline void _mapReadsImpl(Mapper<TSpec, TConfig> & me, TReadSeqs & readSeqs, All
 template <typename TSpec, typename TConfig, typename TReadSeqs>
 inline void _mapReadsImpl(Mapper<TSpec, TConfig> & me, TReadSeqs & readSeqs, Strata)
 {
-    initReadsContext(me, readSeqs);
     initSeeds(me, readSeqs);
 
     collectSeeds<0>(me, readSeqs);
@@ -1074,14 +1273,6 @@ inline void _mapReadsImpl(Mapper<TSpec, TConfig> & me, TReadSeqs & readSeqs, Str
         clearHits(me);
         clearSeeds(me);
     }
-
-    aggregateMatches(me, readSeqs);
-//    verifyMatches(me, readSeqs);
-    rankMatches(me, readSeqs);
-    alignMatches(me);
-    writeMatches(me);
-    clearMatches(me);
-    clearAlignments(me);
 }
 
 // ----------------------------------------------------------------------------
@@ -1155,9 +1346,10 @@ inline void runMapper(Mapper<TSpec, TConfig> & me)
     }
 
     // Close output file.
-    close(me.outputStream);
+    closeOutput(me);
 
     // Close reads file.
+    close(me.readsRing);
     close(me.readsLoader);
 
     stop(timer);
@@ -1175,21 +1367,24 @@ template <typename TExecSpace,
           typename TInputType,
           typename TOutputFormat,
           typename TSequencing,
-          typename TStrategy>
+          typename TStrategy,
+          typename TIndexConfig>
 inline void spawnMapper(Options const & options,
                         TExecSpace const & /* tag */,
                         TThreading const & /* tag */,
                         TInputType const & /* tag */,
                         TOutputFormat const & /* tag */,
                         TSequencing const & /* tag */,
-                        TStrategy const & /* tag */)
+                        TStrategy const & /* tag */,
+                        TIndexConfig const & /* tag */)
 {
     typedef ReadMapperConfig<TExecSpace,
                              TThreading,
                              TInputType,
                              TOutputFormat,
                              TSequencing,
-                             TStrategy> TConfig;
+                             TStrategy,
+                             TIndexConfig> TConfig;
 
     Mapper<void, TConfig> mapper(options);
     runMapper(mapper);
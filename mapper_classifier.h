@@ -83,6 +83,45 @@ struct ReadsClassifier
     }
 };
 
+// ----------------------------------------------------------------------------
+// Class RepeatsClassifier
+// ----------------------------------------------------------------------------
+// One instance per thread.
+
+template <typename TSpec, typename TConfig>
+struct RepeatsClassifier
+{
+    typedef typename TConfig::TReadsContext     TReadsContext;
+    typedef typename TConfig::TRepeatsTable     TRepeatsTable;
+    typedef typename TConfig::TReadSeqs         TReadSeqs;
+
+    // Shared-memory read-write data.
+    TReadsContext &         ctx;
+
+    // Shared-memory read-only data.
+    TRepeatsTable const &   repeats;
+    TReadSeqs const &       readSeqs;
+    Options const &         options;
+
+    RepeatsClassifier(TReadsContext & ctx,
+                      TRepeatsTable const & repeats,
+                      TReadSeqs const & readSeqs,
+                      Options const & options) :
+        ctx(ctx),
+        repeats(repeats),
+        readSeqs(readSeqs),
+        options(options)
+    {
+        _classifyRepeatsImpl(*this, typename TConfig::TStrategy());
+    }
+
+    template <typename TReadSeqsIterator>
+    void operator() (TReadSeqsIterator const & it)
+    {
+        _classifyRepeatImpl(*this, it, typename TConfig::TStrategy());
+    }
+};
+
 // ============================================================================
 // Functions
 // ============================================================================
@@ -276,4 +315,98 @@ inline void _classifyReadImpl(ReadsClassifier<TSpec, TConfig> & me, TReadSeqsIte
     }
 }
 
+// ----------------------------------------------------------------------------
+// Function _classifyRepeatsImpl()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TConfig>
+inline void _classifyRepeatsImpl(RepeatsClassifier<TSpec, TConfig> & me, All)
+{
+    // Iterate over all reads.
+    iterate(me.readSeqs, me, Rooted(), typename TConfig::TThreading());
+}
+
+template <typename TSpec, typename TConfig>
+inline void _classifyRepeatsImpl(RepeatsClassifier<TSpec, TConfig> & me, Strata)
+{
+    typedef typename TConfig::TReadSeqs             TReadSeqs;
+    typedef Segment<TReadSeqs const, PrefixSegment> TPrefix;
+
+    TPrefix pairs(me.readSeqs, getReadsCount(me.readSeqs));
+
+    // Iterate over all pairs.
+    iterate(pairs, me, Rooted(), typename TConfig::TThreading());
+}
+
+// ----------------------------------------------------------------------------
+// Function _getRepeatHits()
+// ----------------------------------------------------------------------------
+// Bounds the hits of the exact seeds of a read sequence by the counts of their frequent k-mers.
+
+template <typename TSpec, typename TConfig, typename TReadSeqId>
+inline __uint64 _getRepeatHits(RepeatsClassifier<TSpec, TConfig> & me, TReadSeqId readSeqId)
+{
+    typedef typename TConfig::TReadSeqs                 TReadSeqs;
+    typedef typename Value<TReadSeqs>::Type             TReadSeq;
+    typedef typename Size<TReadSeq>::Type               TSize;
+
+    TReadSeq const & readSeq = me.readSeqs[readSeqId];
+
+    // Enumerate the seeds like the SeedsCollector.
+    TSize readLength = length(readSeq);
+    TSize seedsCount = getReadErrors(me.options, readLength) + 1;
+    TSize seedsLength = readLength / seedsCount;
+
+    __uint64 readHits = 0;
+    for (TSize seedId = 0; seedId < seedsCount; ++seedId)
+        readHits += getCount(me.repeats, infixWithLength(readSeq, seedId * seedsLength, seedsLength));
+
+    return readHits;
+}
+
+// ----------------------------------------------------------------------------
+// Function _classifyRepeatImpl(); All
+// ----------------------------------------------------------------------------
+// Raises the seeds errors of the reads whose exact seeds are known to be frequent, as classifyReads() would.
+
+template <typename TSpec, typename TConfig, typename TReadSeqsIterator>
+inline void _classifyRepeatImpl(RepeatsClassifier<TSpec, TConfig> & me, TReadSeqsIterator const & it, All)
+{
+    typedef typename TConfig::TReadSeqs                 TReadSeqs;
+    typedef typename Size<TReadSeqs>::Type              TReadId;
+
+    TReadId readSeqId = position(it);
+
+    __uint64 readHits = _getRepeatHits(me, readSeqId);
+
+    if (readHits > me.options.hitsThreshold)
+        setSeedErrors(me.ctx, readSeqId, (readHits < 200 * me.options.hitsThreshold) ? 1 : 2);
+}
+
+// ----------------------------------------------------------------------------
+// Function _classifyRepeatImpl(); Strata
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TConfig, typename TReadSeqsIterator>
+inline void _classifyRepeatImpl(RepeatsClassifier<TSpec, TConfig> & me, TReadSeqsIterator const & it, Strata)
+{
+    typedef typename TConfig::TReadSeqs                 TReadSeqs;
+    typedef typename Size<TReadSeqs>::Type              TReadId;
+
+    TReadId fwdSeqId = position(it);
+    TReadId revSeqId = getFirstMateRevSeqId(me.readSeqs, fwdSeqId);
+
+    // A double-stranded index counts the k-mers of both strands already.
+    __uint64 readHits = _getRepeatHits(me, fwdSeqId);
+    if (!me.options.indexDoubleStranded)
+        readHits += _getRepeatHits(me, revSeqId);
+
+    if (readHits > me.options.hitsThreshold)
+    {
+        unsigned seedErrors = (readHits < 2 * 200 * me.options.hitsThreshold) ? 1 : 2;
+        setSeedErrors(me.ctx, fwdSeqId, seedErrors);
+        setSeedErrors(me.ctx, revSeqId, seedErrors);
+    }
+}
+
 #endif  // #ifndef APP_YARA_MAPPER_CLASSIFIER_H_
@@ -131,6 +131,9 @@ inline void _collectSeedsImpl(SeedsCollector<TSpec, Traits> & me, TReadSeqsItera
     TReadSeqId readSeqId = position(it);
     TReadSeqId readId = getReadId(me.readSeqs, readSeqId);
 
+    // A double-stranded index finds the seeds of the reverse read sequences on the reverse strand.
+    if (me.options.indexDoubleStranded && isRevReadSeq(me.readSeqs, readSeqId)) return;
+
     if (!isMapped(me.ctx, readId) && getSeedErrors(me.ctx, readSeqId) == me.seedErrors)
         _getSeeds(me, readSeqId);
 }
@@ -51,6 +51,7 @@ struct HitsExtender
 {
     typedef typename Traits::TContigSeqs       TContigSeqs;
     typedef typename Traits::TContigsPos       TContigsPos;
+    typedef typename Traits::TContigsBoundaries TContigsBoundaries;
     typedef typename Traits::TReadSeqs         TReadSeqs;
     typedef typename Traits::TReadSeq          TReadSeq;
     typedef typename Traits::TReadsContext     TReadsContext;
@@ -75,6 +76,8 @@ struct HitsExtender
 
     // Shared-memory read-only data.
     TContigSeqs const & contigSeqs;
+    TContigsBoundaries const & contigsBoundaries;
+    ContigsMask const & contigsMask;
     TReadSeqs &         readSeqs;
     TSeeds const &      seeds;
     THits const &       hits;
@@ -86,6 +89,8 @@ struct HitsExtender
     HitsExtender(TReadsContext & ctx,
                  TMatches & matches,
                  TContigSeqs const & contigSeqs,
+                 TContigsBoundaries const & contigsBoundaries,
+                 ContigsMask const & contigsMask,
                  TSeeds const & seeds,
                  THits const & hits,
                  TRanks const & ranks,
@@ -97,6 +102,8 @@ struct HitsExtender
         ctx(ctx),
         matches(matches),
         contigSeqs(contigSeqs),
+        contigsBoundaries(contigsBoundaries),
+        contigsMask(contigsMask),
         readSeqs(host(seeds)),
         seeds(seeds),
         hits(hits),
@@ -157,6 +164,9 @@ template <typename TSpec, typename Traits, typename THitsIterator, typename TStr
 inline void _extendHitImpl(HitsExtender<TSpec, Traits> & me, THitsIterator const & hitsIt, TStrategy const & /* tag */)
 {
     typedef typename Traits::TContigsPos                TContigsPos;
+    typedef typename Traits::TContigSeqs                TContigSeqs;
+    typedef typename Value<TContigSeqs>::Type           TContigSeq;
+    typedef typename Size<TContigSeq>::Type             TContigSize;
 
     typedef typename Traits::TReadSeqs                  TReadSeqs;
     typedef typename Traits::TReadSeq                   TReadSeq;
@@ -187,33 +197,55 @@ inline void _extendHitImpl(HitsExtender<TSpec, Traits> & me, THitsIterator const
     THitErrors hitErrors = getErrors(me.hits, hitId);
 
     // Get read.
-    TReadId readSeqId = getReadSeqId(me.seeds, seedId);
-    TReadSeq const & readSeq = me.readSeqs[readSeqId];
-
-    // Fill readSeqId.
-    setReadId(me.prototype, me.readSeqs, readSeqId);
+    TReadId seedSeqId = getReadSeqId(me.seeds, seedId);
+    TReadSeq const & readSeq = me.readSeqs[seedSeqId];
 
     // Get position in read.
-    TReadPos readPos = getPosInRead(me.seeds, seedId);
-    TReadSeqSize seedLength = getValueI2(readPos) - getValueI1(readPos);
+    TReadPos seedPos = getPosInRead(me.seeds, seedId);
+    TReadSeqSize seedLength = getValueI2(seedPos) - getValueI1(seedPos);
 
     for (TSAPos saPos = getValueI1(hitRange); saPos < getValueI2(hitRange); ++saPos)
     {
-        // Invert SA value.
+        // Translate the SA value into a position in the reversed contig.
         TSAValue saValue = me.sa[saPos];
-        SEQAN_ASSERT_GEQ(suffixLength(saValue, me.contigSeqs), seedLength);
-        if (suffixLength(saValue, me.contigSeqs) < seedLength) continue;
-        setSeqOffset(saValue, suffixLength(saValue, me.contigSeqs) - seedLength);
+        TContigsPos contigBegin;
+        bool revStrand = posLocalize(contigBegin, saValue, me.contigsBoundaries);
+
+        // Invert SA value.
+        TContigSize contigLength = length(me.contigSeqs[getSeqNo(contigBegin)]);
+        TContigSize suffixLength = contigLength - getSeqOffset(contigBegin);
+        SEQAN_ASSERT_GEQ(suffixLength, seedLength);
+        if (suffixLength < seedLength) continue;
+        setSeqOffset(contigBegin, suffixLength - seedLength);
+
+        TReadId readSeqId = seedSeqId;
+        TReadPos readPos = seedPos;
+
+        // A seed on the reverse strand of a double-stranded index is the reverse complemented seed
+        // of the reverse read sequence on the forward strand.
+        if (revStrand)
+        {
+            TReadSeqSize readLength = length(readSeq);
+            setSeqOffset(contigBegin, contigLength - getSeqOffset(contigBegin) - seedLength);
+            readSeqId = getRevSeqId(me.readSeqs, seedSeqId);
+            readPos = TReadPos(readLength - getValueI2(seedPos), readLength - getValueI1(seedPos));
+        }
+
+        // Fill readSeqId.
+        setReadId(me.prototype, me.readSeqs, readSeqId);
 
         // Compute position in contig.
-        TContigsPos contigBegin = saValue;
         TContigsPos contigEnd = posAdd(contigBegin, seedLength);
 
+        // Skip the seed occurrences overlapping more masked Ns than the seed errors, Ns always mismatch.
+        __uint64 seedBegin = posGlobalize(contigBegin, stringSetLimits(me.contigSeqs));
+        if (getMaskedLength(me.contigsMask, seedBegin, seedBegin + seedLength) > me.seedErrors) continue;
+
         // Get absolute number of errors.
         TErrors maxErrors = getReadErrors(me.options, length(readSeq));
 
         extend(me.extender,
-               readSeq,
+               me.readSeqs[readSeqId],
                contigBegin, contigEnd,
                getValueI1(readPos), getValueI2(readPos),
                hitErrors, maxErrors,
@@ -247,7 +279,9 @@ inline void _extendHitImpl(HitsExtender<TSpec, Traits> & me, TReadSeqsIterator c
 
     TRank fwdRank = me.ranks[fwdSeqId];
     TRank revRank = me.ranks[revSeqId];
-    SEQAN_ASSERT_EQ(length(fwdRank), length(revRank));
+
+    // A double-stranded index collects no seeds for the reverse read sequence.
+    SEQAN_ASSERT(me.options.indexDoubleStranded ? empty(revRank) : length(fwdRank) == length(revRank));
 
     // TODO(esiragusa): Get hits of fwd and rev read seq.
 //    THits fwdHits = getHits(me.hits, fwdSeqId);
@@ -259,18 +293,23 @@ inline void _extendHitImpl(HitsExtender<TSpec, Traits> & me, TReadSeqsIterator c
     {
         // Get seedIds by rank.
         TSeedId fwdSeedId = fwdRank[seedRank];
-        TSeedId revSeedId = revRank[seedRank];
 
         // Get hits.
         THitIds fwdHitIds = getHitIds(me.hits, fwdSeedId);
-        THitIds revHitIds = getHitIds(me.hits, revSeedId);
 
         // Verify seed hits.
         THitsIt hitsBegin = begin(me.hits, Standard());
         for (THitsIt it = hitsBegin + getValueI1(fwdHitIds); it != hitsBegin + getValueI2(fwdHitIds); ++it)
             _extendHitImpl(me, it, All());
-        for (THitsIt it = hitsBegin + getValueI1(revHitIds); it != hitsBegin + getValueI2(revHitIds); ++it)
-            _extendHitImpl(me, it, All());
+
+        if (seedRank < length(revRank))
+        {
+            TSeedId revSeedId = revRank[seedRank];
+            THitIds revHitIds = getHitIds(me.hits, revSeedId);
+
+            for (THitsIt it = hitsBegin + getValueI1(revHitIds); it != hitsBegin + getValueI2(revHitIds); ++it)
+                _extendHitImpl(me, it, All());
+        }
 
         // Mark mapped reads.
         if (getMinErrors(me.ctx, readId) <= seedRank * (me.seedErrors + 1))
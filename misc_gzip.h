@@ -0,0 +1,505 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file contains the GZInput class, a gzip input stream decompressed ahead of its reader.
+
+#ifndef APP_YARA_MISC_GZIP_H_
+#define APP_YARA_MISC_GZIP_H_
+
+#if SEQAN_HAS_ZLIB
+
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <zlib.h>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/parallel.h>
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class GZChunk
+// ----------------------------------------------------------------------------
+// One slot of decompressed data, the last chunk of the file is marked as such.
+
+struct GZChunk
+{
+    CharString  data;
+    bool        ready;
+    bool        last;
+
+    GZChunk() :
+        ready(false),
+        last(false)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class GZInput
+// ----------------------------------------------------------------------------
+// Decompresses a gzip file into a ring of chunks ahead of its reader.
+// BGZF files are split into groups of blocks inflated by several threads,
+// other gzip files are inflated by one thread pipelined with the reader.
+
+struct GZInput
+{
+    // Number of chunks in the ring, thus of chunks decompressed ahead.
+    static const unsigned CHUNKS = 32;
+    // Number of BGZF blocks per chunk, each block holds at most 64 KB.
+    static const unsigned CHUNK_BLOCKS = 64;
+    // Size of one chunk of plain gzip.
+    static const unsigned CHUNK_SIZE = 4u << 20;
+
+    std::ifstream               file;
+    bool                        bgzf;
+
+    String<GZChunk>             chunks;
+    std::vector<std::thread>    threads;
+    std::mutex                  mutex;
+    std::condition_variable     filled;
+    std::condition_variable     emptied;
+
+    // Producers state.
+    __uint64                    fillChunk;
+    bool                        fileEnd;
+    bool                        stop;
+    bool                        error;
+
+    // Reader state.
+    __uint64                    readChunk;
+    unsigned                    readPos;
+    bool                        eof;
+
+    GZInput() :
+        bgzf(false),
+        fillChunk(0),
+        fileEnd(false),
+        stop(false),
+        error(false),
+        readChunk(0),
+        readPos(0),
+        eof(false)
+    {}
+
+    ~GZInput();
+};
+
+// ============================================================================
+// Metafunctions
+// ============================================================================
+
+namespace seqan {
+template <>
+struct Value<GZInput>
+{
+    typedef char Type;
+};
+
+template <>
+struct Size<GZInput>
+{
+    typedef size_t Type;
+};
+
+template <>
+struct Position<GZInput>
+{
+    typedef size_t Type;
+};
+}
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _isBgzf()
+// ----------------------------------------------------------------------------
+// A BGZF block is a gzip member whose first extra subfield 'BC' stores the block size minus one.
+
+inline bool _isBgzf(unsigned char const * header)
+{
+    return header[0] == 31 && header[1] == 139 && header[2] == 8 && (header[3] & 4) &&
+           header[10] >= 6 && header[12] == 'B' && header[13] == 'C' && header[14] == 2;
+}
+
+// ----------------------------------------------------------------------------
+// Function _readBgzfBlocks()
+// ----------------------------------------------------------------------------
+// Reads up to CHUNK_BLOCKS whole BGZF blocks, to be called with the mutex held.
+
+inline bool _readBgzfBlocks(GZInput & me, CharString & blocks)
+{
+    static const unsigned HEADER_SIZE = 18;
+
+    clear(blocks);
+
+    for (unsigned blockId = 0; blockId < GZInput::CHUNK_BLOCKS; ++blockId)
+    {
+        unsigned char header[HEADER_SIZE];
+
+        if (!me.file.read(reinterpret_cast<char *>(header), HEADER_SIZE))
+        {
+            me.fileEnd = true;
+            return me.file.gcount() == 0;
+        }
+
+        if (!_isBgzf(header))
+            return false;
+
+        unsigned blockSize = (header[16] | (header[17] << 8)) + 1;
+        unsigned blocksSize = length(blocks);
+
+        resize(blocks, blocksSize + blockSize, Exact());
+        std::copy(header, header + HEADER_SIZE, begin(blocks, Standard()) + blocksSize);
+
+        if (!me.file.read(&blocks[blocksSize + HEADER_SIZE], blockSize - HEADER_SIZE))
+            return false;
+    }
+
+    me.fileEnd = me.file.peek() == std::char_traits<char>::eof();
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function _inflateBlocks()
+// ----------------------------------------------------------------------------
+// Inflates a sequence of whole gzip members.
+
+inline bool _inflateBlocks(CharString & data, CharString & blocks)
+{
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    zs.next_in = reinterpret_cast<Bytef *>(begin(blocks, Standard()));
+    zs.avail_in = length(blocks);
+
+    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+        return false;
+
+    clear(data);
+
+    int status = Z_OK;
+    while (zs.avail_in > 0)
+    {
+        // Each BGZF block inflates to at most 64 KB.
+        unsigned dataSize = length(data);
+        resize(data, dataSize + (1u << 16), Generous());
+        zs.next_out = reinterpret_cast<Bytef *>(begin(data, Standard()) + dataSize);
+        zs.avail_out = 1u << 16;
+
+        status = inflate(&zs, Z_NO_FLUSH);
+        resize(data, length(data) - zs.avail_out);
+
+        if (status == Z_STREAM_END)
+            status = inflateReset(&zs);
+
+        if (status != Z_OK)
+            break;
+    }
+
+    inflateEnd(&zs);
+
+    return status == Z_OK;
+}
+
+// ----------------------------------------------------------------------------
+// Function _bgzfWorker()
+// ----------------------------------------------------------------------------
+// Reads the next group of blocks in file order, then inflates it concurrently with the other workers.
+
+inline void _bgzfWorker(GZInput & me)
+{
+    CharString blocks;
+
+    while (true)
+    {
+        __uint64 chunkId;
+        bool ok;
+        bool last;
+
+        {
+            std::unique_lock<std::mutex> lock(me.mutex);
+
+            me.emptied.wait(lock, [&me] { return me.stop || me.fileEnd ||
+                                                 me.fillChunk < me.readChunk + GZInput::CHUNKS; });
+
+            if (me.stop || me.fileEnd) return;
+
+            chunkId = me.fillChunk++;
+            ok = _readBgzfBlocks(me, blocks);
+            last = me.fileEnd || !ok;
+            if (!ok) me.fileEnd = true;
+        }
+
+        GZChunk & chunk = me.chunks[chunkId % GZInput::CHUNKS];
+        ok = _inflateBlocks(chunk.data, blocks) && ok;
+
+        // A chunk failing to inflate ends the data seen by the reader.
+        {
+            std::lock_guard<std::mutex> lock(me.mutex);
+            me.error |= !ok;
+            me.fileEnd |= !ok;
+            chunk.last = last || !ok;
+            chunk.ready = true;
+        }
+        me.filled.notify_all();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _gzipWorker()
+// ----------------------------------------------------------------------------
+// Inflates the whole file chunk by chunk, concatenated gzip members are inflated one after the other.
+// The file must end with a whole member, thus a truncated file is an error.
+
+inline void _gzipWorker(GZInput & me)
+{
+    static const unsigned BUFFER_SIZE = 1u << 16;
+
+    char buffer[BUFFER_SIZE];
+
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    zs.next_in = Z_NULL;
+    zs.avail_in = 0;
+
+    bool ok = inflateInit2(&zs, 16 + MAX_WBITS) == Z_OK;
+    bool memberEnd = false;
+
+    for (__uint64 chunkId = 0; ; ++chunkId)
+    {
+        {
+            std::unique_lock<std::mutex> lock(me.mutex);
+            me.emptied.wait(lock, [&me, chunkId] { return me.stop || chunkId < me.readChunk + GZInput::CHUNKS; });
+            if (me.stop) break;
+        }
+
+        GZChunk & chunk = me.chunks[chunkId % GZInput::CHUNKS];
+        clear(chunk.data);
+
+        bool last = !ok;
+        while (ok && length(chunk.data) < GZInput::CHUNK_SIZE)
+        {
+            if (zs.avail_in == 0)
+            {
+                me.file.read(buffer, BUFFER_SIZE);
+                zs.next_in = reinterpret_cast<Bytef *>(buffer);
+                zs.avail_in = me.file.gcount();
+
+                if (zs.avail_in == 0)
+                {
+                    ok = memberEnd && !me.file.bad();
+                    last = true;
+                    break;
+                }
+            }
+
+            unsigned dataSize = length(chunk.data);
+            resize(chunk.data, dataSize + BUFFER_SIZE, Generous());
+            zs.next_out = reinterpret_cast<Bytef *>(begin(chunk.data, Standard()) + dataSize);
+            zs.avail_out = BUFFER_SIZE;
+
+            int status = inflate(&zs, Z_NO_FLUSH);
+            resize(chunk.data, length(chunk.data) - zs.avail_out);
+
+            memberEnd = status == Z_STREAM_END;
+
+            if (status == Z_STREAM_END)
+                status = inflateReset(&zs);
+
+            ok = (status == Z_OK || status == Z_BUF_ERROR);
+            last = !ok;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(me.mutex);
+            me.error |= !ok;
+            chunk.last = last;
+            chunk.ready = true;
+        }
+        me.filled.notify_all();
+
+        if (last) break;
+    }
+
+    inflateEnd(&zs);
+}
+
+// ----------------------------------------------------------------------------
+// Function close()
+// ----------------------------------------------------------------------------
+
+inline void close(GZInput & me)
+{
+    {
+        std::lock_guard<std::mutex> lock(me.mutex);
+        me.stop = true;
+    }
+    me.emptied.notify_all();
+
+    for (unsigned threadId = 0; threadId < me.threads.size(); ++threadId)
+        me.threads[threadId].join();
+    me.threads.clear();
+
+    if (me.file.is_open())
+        me.file.close();
+}
+
+// ----------------------------------------------------------------------------
+// GZInput Destructor
+// ----------------------------------------------------------------------------
+
+inline GZInput::~GZInput()
+{
+    close(*this);
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+// Starts decompressing the file, on as many threads as OpenMP can spawn if the file is BGZF.
+
+inline bool open(GZInput & me, char const * fileName, int /* mode */)
+{
+    static const unsigned HEADER_SIZE = 18;
+
+    close(me);
+
+    me.file.open(fileName, std::ios::in | std::ios::binary);
+    if (!me.file.is_open()) return false;
+
+    unsigned char header[HEADER_SIZE] = {};
+    me.file.read(reinterpret_cast<char *>(header), HEADER_SIZE);
+    me.bgzf = me.file.gcount() == HEADER_SIZE && _isBgzf(header);
+    me.file.clear();
+    me.file.seekg(0, std::ios::beg);
+
+    clear(me.chunks);
+    resize(me.chunks, GZInput::CHUNKS);
+    me.fillChunk = 0;
+    me.fileEnd = false;
+    me.stop = false;
+    me.error = false;
+    me.readChunk = 0;
+    me.readPos = 0;
+    me.eof = false;
+
+    if (me.bgzf)
+        for (int threadId = 0; threadId < std::max(omp_get_max_threads(), 1); ++threadId)
+            me.threads.push_back(std::thread(_bgzfWorker, std::ref(me)));
+    else
+        me.threads.push_back(std::thread(_gzipWorker, std::ref(me)));
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function streamReadBlock()
+// ----------------------------------------------------------------------------
+// Copies the decompressed data in file order, waiting for the chunks not yet decompressed.
+
+inline size_t streamReadBlock(char * target, GZInput & me, size_t maxLen)
+{
+    size_t copied = 0;
+
+    while (copied < maxLen && !me.eof)
+    {
+        GZChunk & chunk = me.chunks[me.readChunk % GZInput::CHUNKS];
+
+        {
+            std::unique_lock<std::mutex> lock(me.mutex);
+            me.filled.wait(lock, [&chunk] { return chunk.ready; });
+        }
+
+        size_t count = std::min(maxLen - copied, static_cast<size_t>(length(chunk.data) - me.readPos));
+        std::copy(begin(chunk.data, Standard()) + me.readPos, begin(chunk.data, Standard()) + me.readPos + count,
+                  target + copied);
+        copied += count;
+        me.readPos += count;
+
+        if (me.readPos < length(chunk.data)) continue;
+
+        // The reader sees the end of a failed stream through streamError().
+        if (chunk.last)
+        {
+            me.eof = true;
+            break;
+        }
+
+        // Give the chunk back to the workers.
+        {
+            std::lock_guard<std::mutex> lock(me.mutex);
+            chunk.ready = false;
+            me.readChunk++;
+            me.readPos = 0;
+        }
+        me.emptied.notify_all();
+    }
+
+    return copied;
+}
+
+// ----------------------------------------------------------------------------
+// Function streamEof()
+// ----------------------------------------------------------------------------
+
+inline bool streamEof(GZInput & me)
+{
+    return me.eof;
+}
+
+// ----------------------------------------------------------------------------
+// Function streamError()
+// ----------------------------------------------------------------------------
+
+inline int streamError(GZInput & me)
+{
+    std::lock_guard<std::mutex> lock(me.mutex);
+    return me.error;
+}
+
+#endif  // #if SEQAN_HAS_ZLIB
+
+#endif  // #ifndef APP_YARA_MISC_GZIP_H_
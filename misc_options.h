@@ -35,6 +35,8 @@
 #ifndef APP_YARA_MISC_OPTIONS_H_
 #define APP_YARA_MISC_OPTIONS_H_
 
+#include <sys/stat.h>
+
 #include <seqan/basic.h>
 #include <seqan/sequence.h>
 #include <seqan/arg_parse.h>
@@ -282,6 +284,23 @@ void getInputType(TOptions & options, TString const & inputFile)
     getOptionEnum(options.inputType, inputTypeExtension, options.inputTypeList);
 }
 
+// ----------------------------------------------------------------------------
+// Function isRegularFile()
+// ----------------------------------------------------------------------------
+// Returns false for named pipes and devices, which cannot be mapped but only streamed.
+
+template <typename TString>
+inline bool isRegularFile(TString const & fileName)
+{
+#ifdef PLATFORM_WINDOWS
+    struct _stat fileStat;
+    return _stat(toCString(fileName), &fileStat) == 0 && (fileStat.st_mode & _S_IFREG);
+#else
+    struct stat fileStat;
+    return stat(toCString(fileName), &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+#endif
+}
+
 // ----------------------------------------------------------------------------
 // Function getOutputFormat()
 // ----------------------------------------------------------------------------
@@ -301,10 +320,13 @@ void getOutputFormat(TOptions & options, TString const & outputFile)
 template <typename TOptions>
 void setOutputFile(ArgumentParser & parser, TOptions const & options)
 {
-    addOption(parser, ArgParseOption("o", "output-file", "Specify an output file. \
+    addOption(parser, ArgParseOption("o", "output-file", "Specify an output file, or - for the standard output. \
                                      Default: use the reads filename prefix.",
                                      ArgParseOption::OUTPUTFILE));
-    setValidValues(parser, "output-file", options.outputFormatList);
+
+    typename TOptions::TList outputFileList = options.outputFormatList;
+    appendValue(outputFileList, "-");
+    setValidValues(parser, "output-file", outputFileList);
 }
 
 // ----------------------------------------------------------------------------
@@ -321,6 +343,13 @@ void getOutputFile(TString & file,
     getOptionValue(file, parser, "output-file");
     if (!isSet(parser, "output-file"))
     {
+        // Reads from the standard input go to the standard output.
+        if (from == "-")
+        {
+            file = from;
+            return;
+        }
+
         file = trimExtension(from);
         append(file, suffix);
         appendValue(file, '.');
@@ -77,7 +77,7 @@ enum LibraryOrientation
 
 enum InputType
 {
-    PLAIN, GZIP, BZIP2
+    PLAIN, GZIP, BZIP2, STREAM
 };
 
 enum OutputFormat
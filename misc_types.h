@@ -40,6 +40,56 @@
 
 using namespace seqan;
 
+// ============================================================================
+// Enums
+// ============================================================================
+
+// The q-gram index adds a direct-addressed table of the suffix array ranges of all q-grams to the FM index.
+enum IndexType
+{
+    FM_INDEX, QGRAM_INDEX
+};
+
+// ============================================================================
+// Tags
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Tag LargeContigs
+// ----------------------------------------------------------------------------
+// Selects 64-bit index positions for references longer than 4 Gbp.
+
+struct LargeContigs_;
+typedef Tag<LargeContigs_> LargeContigs;
+
+// ----------------------------------------------------------------------------
+// Tag Interleaved
+// ----------------------------------------------------------------------------
+// Selects the rank dictionary storing counts and symbols in lines of LINE_SIZE bytes.
+
+namespace seqan {
+template <typename TSpec = void, unsigned LINE_SIZE = 64>
+struct Interleaved {};
+}
+
+// ----------------------------------------------------------------------------
+// Tag SparseBits
+// ----------------------------------------------------------------------------
+// Selects the rank dictionary storing only the positions of the set bits.
+
+namespace seqan {
+template <typename TSpec = void>
+struct SparseBits {};
+}
+
+// ----------------------------------------------------------------------------
+// Tag CompressedIndex
+// ----------------------------------------------------------------------------
+// Selects the index profile trading search speed for a smaller index.
+
+struct CompressedIndex_;
+typedef Tag<CompressedIndex_> CompressedIndex;
+
 // ============================================================================
 // Yara Limits
 // ============================================================================
@@ -51,13 +101,24 @@ using namespace seqan;
 template <typename TSpec = void>
 struct YaraBits
 {
-    static const unsigned CONTIG_ID   = 8;
+    static const unsigned CONTIG_ID   = 24;
     static const unsigned CONTIG_SIZE = 30;
     static const unsigned READ_ID     = 21;
     static const unsigned READ_SIZE   = 14;
     static const unsigned ERRORS      = 6;
 };
 
+// Contig positions are limited to 31 bits by SAM/BAM.
+template <>
+struct YaraBits<LargeContigs>
+{
+    static const unsigned CONTIG_ID   = 23;
+    static const unsigned CONTIG_SIZE = 31;
+    static const unsigned READ_ID     = 21;
+    static const unsigned READ_SIZE   = 14;
+    static const unsigned ERRORS      = 6;
+};
+
 // ----------------------------------------------------------------------------
 // Class YaraLimits
 // ----------------------------------------------------------------------------
@@ -80,11 +141,14 @@ struct YaraLimits
 // String Spec
 // ----------------------------------------------------------------------------
 
-//#ifndef YARA_INDEXER
-//typedef MMap<>  YaraStringSpec;
-//#else
+// The mapper maps the reference and its index read-only, thus
+// concurrent mapper processes share the same page cache copy of the index.
+
+#ifndef YARA_INDEXER
+typedef MMap<>  YaraStringSpec;
+#else
 typedef Alloc<> YaraStringSpec;
-//#endif
+#endif
 
 // ----------------------------------------------------------------------------
 // ReadSeqs Size
@@ -158,20 +222,53 @@ typedef Alloc<> YaraStringSpec;
 
 typedef StringSet<String<Dna5, Packed<YaraStringSpec> >, Owner<ConcatDirect<> > >   YaraContigs;
 typedef StringSet<String<Dna>, Owner<ConcatDirect<> > >                             YaraContigsFM;
+typedef StringSet<String<Dna, Alloc<LargeContigs> >, Owner<ConcatDirect<> > >       YaraLargeContigsFM;
+
+// ----------------------------------------------------------------------------
+// Metafunction YaraIndexText
+// ----------------------------------------------------------------------------
+
+template <typename TSizeSpec = void>
+struct YaraIndexText
+{
+    typedef YaraContigsFM Type;
+};
+
+template <>
+struct YaraIndexText<LargeContigs>
+{
+    typedef YaraLargeContigsFM Type;
+};
 
 // ----------------------------------------------------------------------------
 // FM Index Fibres
 // ----------------------------------------------------------------------------
 
+// SAMPLING is only the default sampling rate, the index is built with the rate given at runtime.
+template <typename TSizeSpec_ = void, typename TProfile_ = void>
 struct YaraFMIndexConfig
 {
-    typedef TwoLevels<void>    TValuesSpec;
-    typedef Naive<void>        TSentinelsSpec;
+    typedef TSizeSpec_              TSizeSpec;
+    typedef TProfile_               TProfile;
+    typedef Interleaved<TSizeSpec_> TValuesSpec;
+    typedef Naive<TSizeSpec_>       TSentinelsSpec;
 
     static const unsigned SAMPLING = 10;
 };
 
-typedef FMIndex<void, YaraFMIndexConfig>        YaraIndexSpec;
+// 256-byte lines store the BWT in 2.1 (32-bit) or 2.3 (64-bit) bits per symbol instead of 2.7 or 4.
+template <typename TSizeSpec_>
+struct YaraFMIndexConfig<TSizeSpec_, CompressedIndex>
+{
+    typedef TSizeSpec_                      TSizeSpec;
+    typedef CompressedIndex                 TProfile;
+    typedef Interleaved<TSizeSpec_, 256>    TValuesSpec;
+    typedef SparseBits<TSizeSpec_>          TSentinelsSpec;
+
+    static const unsigned SAMPLING = 10;
+};
+
+typedef FMIndex<void, YaraFMIndexConfig<> >     YaraIndexSpec;
 typedef Index<YaraContigsFM, YaraIndexSpec>     YaraIndex;
 
 // ----------------------------------------------------------------------------
@@ -179,27 +276,39 @@ typedef Index<YaraContigsFM, YaraIndexSpec>     YaraIndex;
 // ----------------------------------------------------------------------------
 
 namespace seqan {
-template <>
-struct Size<YaraIndex>
+template <typename TSpec, typename TConfig>
+struct Size<Index<YaraContigsFM, FMIndex<TSpec, TConfig> > >
 {
     typedef __uint32 Type;
 };
 
-template <>
-struct Size<View<YaraIndex>::Type>
+template <typename TSpec, typename TConfig>
+struct Size<Index<View<YaraContigsFM>::Type, FMIndex<TSpec, TConfig> > >
 {
     typedef __uint32 Type;
 };
 
+template <typename TSpec, typename TConfig>
+struct Size<Index<YaraLargeContigsFM, FMIndex<TSpec, TConfig> > >
+{
+    typedef __uint64 Type;
+};
+
+template <typename TSpec, typename TConfig>
+struct Size<Index<View<YaraLargeContigsFM>::Type, FMIndex<TSpec, TConfig> > >
+{
+    typedef __uint64 Type;
+};
+
 #ifdef PLATFORM_CUDA
-template <>
-struct Size<Device<YaraIndex>::Type>
+template <typename TSpec, typename TConfig>
+struct Size<Index<Device<YaraContigsFM>::Type, FMIndex<TSpec, TConfig> > >
 {
     typedef __uint32 Type;
 };
 
-template <>
-struct Size<View<Device<YaraIndex>::Type>::Type>
+template <typename TSpec, typename TConfig>
+struct Size<Index<View<Device<YaraContigsFM>::Type>::Type, FMIndex<TSpec, TConfig> > >
 {
     typedef __uint32 Type;
 };
@@ -217,41 +326,93 @@ struct DefaultIndexStringSpec<YaraContigsFM>
     typedef YaraStringSpec Type;
 };
 
+template <typename TConfig>
+struct DefaultIndexStringSpec<CompressedSA<YaraContigsFM, void, TConfig> >
+{
+    typedef YaraStringSpec Type;
+};
+
 template <>
-struct DefaultIndexStringSpec<CompressedSA<YaraContigsFM, void, YaraFMIndexConfig> >
+struct DefaultIndexStringSpec<YaraLargeContigsFM>
+{
+    typedef YaraStringSpec Type;
+};
+
+template <typename TConfig>
+struct DefaultIndexStringSpec<CompressedSA<YaraLargeContigsFM, void, TConfig> >
 {
     typedef YaraStringSpec Type;
 };
 }
 
 // ----------------------------------------------------------------------------
-// Suffix Array Value Type
+// Contigs Position Type
 // ----------------------------------------------------------------------------
+// (contig, offset) pairs are only used one at a time, to localize SA values and to extend hits.
 
 namespace seqan {
 template <>
 struct StringSetPosition<YaraContigs>
 {
-    typedef Pair<__uint8, __uint32, Pack> Type;
+    typedef Pair<__uint32, __uint32, Pack> Type;
 };
 
 template <>
 struct StringSetPosition<YaraContigsFM>
 {
-    typedef Pair<__uint8, __uint32, Pack> Type;
+    typedef Pair<__uint32, __uint32, Pack> Type;
+};
+
+template <>
+struct StringSetPosition<YaraLargeContigsFM>
+{
+    typedef Pair<__uint32, __uint32, Pack> Type;
 };
 
 template <>
 struct StringSetPosition<View<YaraContigsFM>::Type>
 {
-    typedef Pair<__uint8, __uint32, Pack> Type;
+    typedef Pair<__uint32, __uint32, Pack> Type;
 };
 
 #ifdef PLATFORM_CUDA
 template <>
 struct StringSetPosition<Device<YaraContigsFM>::Type>
 {
-    typedef Pair<__uint8, __uint32, Pack> Type;
+    typedef Pair<__uint32, __uint32, Pack> Type;
+};
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Suffix Array Value Type
+// ----------------------------------------------------------------------------
+// The SA stores positions in the concatenation of all contigs.
+
+namespace seqan {
+template <>
+struct SAValue<YaraContigsFM>
+{
+    typedef __uint32 Type;
+};
+
+template <>
+struct SAValue<YaraLargeContigsFM>
+{
+    typedef __uint64 Type;
+};
+
+template <>
+struct SAValue<View<YaraContigsFM>::Type>
+{
+    typedef __uint32 Type;
+};
+
+#ifdef PLATFORM_CUDA
+template <>
+struct SAValue<Device<YaraContigsFM>::Type>
+{
+    typedef __uint32 Type;
 };
 #endif
 }
@@ -266,6 +427,12 @@ struct Size<LF<YaraContigsFM, TSpec, TConfig> >
 {
     typedef __uint32 Type;
 };
+
+template <typename TSpec, typename TConfig>
+struct Size<LF<YaraLargeContigsFM, TSpec, TConfig> >
+{
+    typedef __uint64 Type;
+};
 }
 
 // ----------------------------------------------------------------------------
@@ -285,11 +452,53 @@ struct Size<RankDictionary<bool, TwoLevels<TSpec> > >
     typedef __uint32 Type;
 };
 
+template <typename TSpec, unsigned LINE_SIZE>
+struct Size<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >
+{
+    typedef __uint32 Type;
+};
+
+template <typename TSpec>
+struct Size<RankDictionary<bool, SparseBits<TSpec> > >
+{
+    typedef __uint32 Type;
+};
+
 template <typename TSpec>
 struct Size<RankDictionary<bool, Naive<TSpec> > >
 {
     typedef __uint32 Type;
 };
+
+template <>
+struct Size<RankDictionary<Dna, TwoLevels<LargeContigs> > >
+{
+    typedef __uint64 Type;
+};
+
+template <>
+struct Size<RankDictionary<bool, TwoLevels<LargeContigs> > >
+{
+    typedef __uint64 Type;
+};
+
+template <unsigned LINE_SIZE>
+struct Size<RankDictionary<Dna, Interleaved<LargeContigs, LINE_SIZE> > >
+{
+    typedef __uint64 Type;
+};
+
+template <>
+struct Size<RankDictionary<bool, SparseBits<LargeContigs> > >
+{
+    typedef __uint64 Type;
+};
+
+template <>
+struct Size<RankDictionary<bool, Naive<LargeContigs> > >
+{
+    typedef __uint64 Type;
+};
 }
 
 // ----------------------------------------------------------------------------
@@ -309,6 +518,18 @@ struct RankDictionaryFibreSpec<RankDictionary<bool, TwoLevels<TSpec> > >
     typedef YaraStringSpec Type;
 };
 
+template <typename TSpec, unsigned LINE_SIZE>
+struct RankDictionaryFibreSpec<RankDictionary<Dna, Interleaved<TSpec, LINE_SIZE> > >
+{
+    typedef YaraStringSpec Type;
+};
+
+template <typename TSpec>
+struct RankDictionaryFibreSpec<RankDictionary<bool, SparseBits<TSpec> > >
+{
+    typedef YaraStringSpec Type;
+};
+
 template <typename TSpec>
 struct RankDictionaryFibreSpec<RankDictionary<bool, Naive<TSpec> > >
 {
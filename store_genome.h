@@ -102,6 +102,7 @@ struct ContigsLoader
     typedef RecordReader<TStream, SinglePass<> >    TRecordReader;
 
     TStream                         _file;
+    CharString                      _fileName;
     unsigned long                   _fileSize;
     AutoSeqStreamFormat             _fileFormat;
     std::auto_ptr<TRecordReader>    _reader;
@@ -111,6 +112,38 @@ struct ContigsLoader
     {}
 };
 
+// ----------------------------------------------------------------------------
+// Class ContigsBoundaries
+// ----------------------------------------------------------------------------
+// Translates positions in the concatenation of all contigs into (contig, offset) pairs.
+// The concatenation is cut into equal buckets, each bucket stores the first contig overlapping it.
+
+template <typename TPos = __uint32>
+struct ContigsBoundaries
+{
+    String<TPos>        limits;
+    String<__uint32>    buckets;
+    unsigned            shift;
+    __uint32            contigsBegin;
+    __uint32            contigsCount;
+
+    ContigsBoundaries() :
+        shift(0),
+        contigsBegin(0),
+        contigsCount(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class ContigsMask
+// ----------------------------------------------------------------------------
+// Stores the sorted runs of Ns as intervals [begin, end) in the concatenation of all contigs.
+
+struct ContigsMask
+{
+    String<Pair<__uint64> > intervals;
+};
+
 // ============================================================================
 // Functions
 // ============================================================================
@@ -184,26 +217,192 @@ inline void removeNs(Contigs<TSpec, TConfig> & me)
         _removeNs(me, contigId, rng);
 }
 
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+// Collects the runs of Ns, thus it must be called before removeNs().
+
+template <typename TSpec, typename TConfig>
+inline void build(ContigsMask & me, Contigs<TSpec, TConfig> const & contigs)
+{
+    typedef Contigs<TSpec, TConfig>                                 TContigs;
+    typedef typename TContigs::TContigSeqs                          TContigSeqs;
+    typedef typename Value<TContigSeqs const>::Type                 TContigSeq;
+    typedef typename Value<TContigSeq>::Type                        TAlphabet;
+    typedef typename Iterator<TContigSeq const, Standard>::Type     TContigIt;
+
+    clear(me.intervals);
+
+    __uint64 contigBegin = 0;
+    for (unsigned contigId = 0; contigId < length(contigs.seqs); ++contigId)
+    {
+        TContigSeq const & contig = contigs.seqs[contigId];
+        TContigIt cBegin = begin(contig, Standard());
+        TContigIt cEnd = end(contig, Standard());
+        TContigIt cIt = cBegin;
+
+        while (cIt != cEnd)
+        {
+            for (; cIt != cEnd && value(cIt) != TAlphabet('N'); ++cIt) ;
+
+            if (cIt == cEnd) break;
+
+            __uint64 runBegin = contigBegin + (cIt - cBegin);
+            for (; cIt != cEnd && value(cIt) == TAlphabet('N'); ++cIt) ;
+
+            appendValue(me.intervals, Pair<__uint64>(runBegin, contigBegin + (cIt - cBegin)));
+        }
+
+        contigBegin += length(contig);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+// Uses about two buckets per contig, thus a lookup scans few contigs on average.
+// The contigs in [contigsBegin, contigsEnd) are localized as if their concatenation started at zero.
+// A double-stranded index concatenates the reverse complemented contigs after the forward ones.
+
+template <typename TPos, typename TLimits, typename TContigId>
+inline void build(ContigsBoundaries<TPos> & me, TLimits const & limits, TContigId contigsBegin, TContigId contigsEnd,
+                  unsigned strands = 1)
+{
+    me.contigsBegin = contigsBegin;
+    me.contigsCount = contigsEnd - contigsBegin;
+
+    TPos strandLength = limits[contigsEnd] - limits[contigsBegin];
+
+    resize(me.limits, strands * me.contigsCount + 1, Exact());
+    for (__uint32 contigId = 0; contigId <= strands * me.contigsCount; ++contigId)
+        me.limits[contigId] = (contigId / me.contigsCount) * strandLength +
+                              limits[contigsBegin + contigId % me.contigsCount] - limits[contigsBegin];
+
+    __uint64 textLength = back(me.limits);
+    __uint64 bucketsCount = 2 * (length(me.limits) - 1);
+
+    for (me.shift = 0; (textLength >> me.shift) > bucketsCount; ++me.shift) ;
+
+    resize(me.buckets, (textLength >> me.shift) + 1, Exact());
+
+    __uint32 contigId = 0;
+    for (__uint64 bucket = 0; bucket < length(me.buckets); ++bucket)
+    {
+        while (contigId + 2 < length(me.limits) && me.limits[contigId + 1] <= (bucket << me.shift))
+            ++contigId;
+        me.buckets[bucket] = contigId;
+    }
+}
+
+template <typename TPos, typename TLimits>
+inline void build(ContigsBoundaries<TPos> & me, TLimits const & limits)
+{
+    build(me, limits, 0u, static_cast<unsigned>(length(limits) - 1));
+}
+
+// ----------------------------------------------------------------------------
+// Function posLocalize()
+// ----------------------------------------------------------------------------
+// Returns true if the position lies on the reverse complement of its contig.
+
+template <typename TContigsPos, typename TPos>
+inline bool posLocalize(TContigsPos & contigPos, TPos pos, ContigsBoundaries<TPos> const & me)
+{
+    __uint32 contigId = me.buckets[pos >> me.shift];
+
+    while (me.limits[contigId + 1] <= pos)
+        ++contigId;
+
+    contigPos.i2 = pos - me.limits[contigId];
+
+    if (contigId < me.contigsCount)
+    {
+        contigPos.i1 = me.contigsBegin + contigId;
+        return false;
+    }
+
+    contigPos.i1 = me.contigsBegin + contigId - me.contigsCount;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function getMaskedLength()
+// ----------------------------------------------------------------------------
+// Returns the number of masked positions within [posBegin, posEnd).
+
+template <typename TPos>
+inline TPos getMaskedLength(ContigsMask const & me, TPos posBegin, TPos posEnd)
+{
+    typedef String<Pair<__uint64> > const                   TIntervals;
+    typedef typename Iterator<TIntervals, Standard>::Type   TIntervalsIt;
+
+    if (empty(me.intervals)) return 0;
+
+    // Find the first interval ending after posBegin.
+    TIntervalsIt it = std::upper_bound(begin(me.intervals, Standard()), end(me.intervals, Standard()),
+                                       Pair<__uint64>(posBegin, MaxValue<__uint64>::VALUE));
+    if (it != begin(me.intervals, Standard()) && getValueI2(*(it - 1)) > (__uint64)posBegin)
+        --it;
+
+    TPos maskedLength = 0;
+    for (; it != end(me.intervals, Standard()) && getValueI1(*it) < (__uint64)posEnd; ++it)
+        maskedLength += std::min((__uint64)posEnd, getValueI2(*it)) - std::max((__uint64)posBegin, getValueI1(*it));
+
+    return maskedLength;
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+template <typename TFileName>
+inline bool open(ContigsMask & me, TFileName const & fileName, int openMode)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".msk");
+    return open(me.intervals, toCString(name), openMode);
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+template <typename TFileName>
+inline bool save(ContigsMask const & me, TFileName const & fileName)
+{
+    CharString name;
+
+    name = fileName;    append(name, ".msk");
+    return save(me.intervals, toCString(name));
+}
+
 // ----------------------------------------------------------------------------
 // Function open()
 // ----------------------------------------------------------------------------
 
 template <typename TSpec, typename TConfig, typename TFileName>
-inline bool open(Contigs<TSpec, TConfig> & me, TFileName const & fileName)
+inline bool open(Contigs<TSpec, TConfig> & me, TFileName const & fileName, int openMode)
 {
     CharString name;
 
     name = fileName;    append(name, ".txt");
-    if (!open(me.seqs, toCString(name))) return false;
+    if (!open(me.seqs, toCString(name), openMode)) return false;
 
     name = fileName;    append(name, ".rid");
-    if (!open(me.names, toCString(name))) return false;
+    if (!open(me.names, toCString(name), openMode)) return false;
 
     refresh(me.namesCache);
 
     return true;
 }
 
+template <typename TSpec, typename TConfig, typename TFileName>
+inline bool open(Contigs<TSpec, TConfig> & me, TFileName const & fileName)
+{
+    return open(me, fileName, OPEN_RDONLY);
+}
+
 // ----------------------------------------------------------------------------
 // Function save()
 // ----------------------------------------------------------------------------
@@ -226,8 +425,23 @@ inline bool save(Contigs<TSpec, TConfig> const & me, TFileName const & fileName)
 // Function load()
 // ----------------------------------------------------------------------------
 
+// Fasta files are parsed and packed in parallel, other formats are read one record at a time.
+
 template <typename TSpec, typename TConfig>
 inline void load(Contigs<TSpec, TConfig> & me, ContigsLoader<TSpec, TConfig> & loader)
+{
+    if (loader._fileFormat.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE)
+        _loadFastaImpl(me, loader);
+    else
+        _loadRecordsImpl(me, loader);
+}
+
+// ----------------------------------------------------------------------------
+// Function _loadRecordsImpl()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TConfig>
+inline void _loadRecordsImpl(Contigs<TSpec, TConfig> & me, ContigsLoader<TSpec, TConfig> & loader)
 {
     // Reserve space for contigs.
     reserve(me, loader._fileSize);
@@ -248,6 +462,149 @@ inline void load(Contigs<TSpec, TConfig> & me, ContigsLoader<TSpec, TConfig> & l
     refresh(me.namesCache);
 }
 
+// ----------------------------------------------------------------------------
+// Function _packContigImpl()
+// ----------------------------------------------------------------------------
+// Packs the bases of the file range [seqBegin, seqEnd), stored at [posBegin, posEnd), that fall within [packBegin, packEnd).
+
+template <typename TContigSeqs, typename TPos, typename TFileIt>
+inline void _packContigImpl(TContigSeqs & seqs, TPos posBegin, TPos posEnd, TPos packBegin, TPos packEnd,
+                            TFileIt seqBegin, TFileIt seqEnd)
+{
+    typedef typename Value<TContigSeqs>::Type   TContigSeq;
+    typedef typename Value<TContigSeq>::Type    TAlphabet;
+
+    TPos pos = posBegin;
+
+    for (TFileIt fIt = seqBegin; fIt != seqEnd && pos < packEnd; ++fIt)
+    {
+        if (isspace(static_cast<unsigned char>(*fIt))) continue;
+
+        if (pos >= packBegin)
+            assignValue(seqs.concat, pos, TAlphabet(*fIt));
+
+        ++pos;
+    }
+
+    SEQAN_ASSERT_LEQ(pos, posEnd);
+    ignoreUnusedVariableWarning(posEnd);
+}
+
+// Packs the bases within [packBegin, posEnd) scanning the file range backwards.
+
+template <typename TContigSeqs, typename TPos, typename TFileIt>
+inline void _packContigTailImpl(TContigSeqs & seqs, TPos packBegin, TPos posEnd, TFileIt seqBegin, TFileIt seqEnd)
+{
+    typedef typename Value<TContigSeqs>::Type   TContigSeq;
+    typedef typename Value<TContigSeq>::Type    TAlphabet;
+
+    TPos pos = posEnd;
+
+    for (TFileIt fIt = seqEnd; fIt != seqBegin && pos > packBegin; )
+    {
+        if (isspace(static_cast<unsigned char>(*(--fIt)))) continue;
+
+        assignValue(seqs.concat, --pos, TAlphabet(*fIt));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _loadFastaImpl()
+// ----------------------------------------------------------------------------
+// Maps the file and splits it at the record boundaries, then counts and packs the records in parallel.
+// The records are appended to the contigs loaded so far, e.g. from previous files.
+// The packed words shared by two contigs are filled serially at the end.
+
+template <typename TSpec, typename TConfig>
+inline void _loadFastaImpl(Contigs<TSpec, TConfig> & me, ContigsLoader<TSpec, TConfig> & loader)
+{
+    typedef Contigs<TSpec, TConfig>                             TContigs;
+    typedef typename TContigs::TContigSeqs                      TContigSeqs;
+    typedef typename Value<TContigSeqs>::Type                   TContigSeq;
+    typedef String<char, MMap<> >                               TFile;
+    typedef typename Iterator<TFile const, Standard>::Type      TFileIt;
+
+    static const __uint64 VALUES_PER_WORD = PackedTraits_<TContigSeq>::VALUES_PER_HOST_VALUE;
+
+    TFile file;
+    if (!open(file, toCString(loader._fileName), OPEN_RDONLY))
+        throw RuntimeError("Error while opening contigs file.");
+
+    TFileIt fileBegin = begin(file, Standard());
+    TFileIt fileEnd = end(file, Standard());
+
+    // Find the records, a record starts with '>' at the beginning of a line.
+    String<TFileIt> records;
+    for (TFileIt fIt = fileBegin; fIt != fileEnd; ++fIt)
+    {
+        fIt = static_cast<TFileIt>(std::memchr(fIt, '>', fileEnd - fIt));
+        if (!fIt) break;
+        if (fIt == fileBegin || *(fIt - 1) == '\n')
+            appendValue(records, fIt);
+    }
+    appendValue(records, fileEnd);
+
+    __int64 recordsCount = length(records) - 1;
+
+    // Read the names and locate the sequences.
+    String<TFileIt> seqsBegin;
+    resize(seqsBegin, recordsCount, Exact());
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        TFileIt nameBegin = records[recordId] + 1;
+        TFileIt nameEnd = static_cast<TFileIt>(std::memchr(nameBegin, '\n', records[recordId + 1] - nameBegin));
+        seqsBegin[recordId] = nameEnd ? nameEnd + 1 : records[recordId + 1];
+        if (!nameEnd) nameEnd = records[recordId + 1];
+
+        for (; nameEnd != nameBegin && isspace(static_cast<unsigned char>(*(nameEnd - 1))); --nameEnd) ;
+        appendValue(me.names, infix(file, nameBegin - fileBegin, nameEnd - fileBegin));
+    }
+
+    // Count the bases of each record.
+    String<__uint64> limits;
+    resize(limits, recordsCount + 1, 0, Exact());
+    limits[0] = lengthSum(me.seqs);
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic))
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        __uint64 seqLength = 0;
+        for (TFileIt fIt = seqsBegin[recordId]; fIt != records[recordId + 1]; ++fIt)
+            seqLength += !isspace(static_cast<unsigned char>(*fIt));
+        limits[recordId + 1] = seqLength;
+    }
+
+    partialSum(limits);
+
+    // Pack the words owned by a single record in parallel.
+    resize(me.seqs.concat, back(limits), Exact());
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+        appendValue(me.seqs.limits, limits[recordId + 1]);
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic))
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        __uint64 headEnd = std::min(limits[recordId + 1], (limits[recordId] + VALUES_PER_WORD - 1) / VALUES_PER_WORD * VALUES_PER_WORD);
+        __uint64 tailBegin = std::max(headEnd, limits[recordId + 1] / VALUES_PER_WORD * VALUES_PER_WORD);
+
+        _packContigImpl(me.seqs, limits[recordId], limits[recordId + 1], headEnd, tailBegin,
+                        seqsBegin[recordId], records[recordId + 1]);
+    }
+
+    // Pack the heads and tails of the records.
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        __uint64 headEnd = std::min(limits[recordId + 1], (limits[recordId] + VALUES_PER_WORD - 1) / VALUES_PER_WORD * VALUES_PER_WORD);
+        __uint64 tailBegin = std::max(headEnd, limits[recordId + 1] / VALUES_PER_WORD * VALUES_PER_WORD);
+
+        _packContigImpl(me.seqs, limits[recordId], limits[recordId + 1], limits[recordId], headEnd,
+                        seqsBegin[recordId], records[recordId + 1]);
+        _packContigTailImpl(me.seqs, tailBegin, limits[recordId + 1], seqsBegin[recordId], records[recordId + 1]);
+    }
+
+    refresh(me.namesCache);
+}
+
 // ----------------------------------------------------------------------------
 // Function open()
 // ----------------------------------------------------------------------------
@@ -262,6 +619,8 @@ inline void open(ContigsLoader<TSpec, TConfig> & loader, TFileName const & conti
     if (!open(loader._file, toCString(contigsFile), OPEN_RDONLY))
         throw RuntimeError("Error while opening contigs file.");
 
+    loader._fileName = contigsFile;
+
     // Compute file size.
     loader._file.seekg(0, std::ios::end);
     loader._fileSize = loader._file.tellg();
@@ -39,9 +39,20 @@
 #ifndef APP_YARA_STORE_READS_H_
 #define APP_YARA_STORE_READS_H_
 
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
 #include <seqan/basic.h>
 #include <seqan/sequence.h>
 #include <seqan/seq_io.h>
+#include <seqan/parallel.h>
+
+#include "misc_gzip.h"
 
 using namespace seqan;
 
@@ -62,6 +73,23 @@ struct ReadsConfig
     typedef Nothing                 TInputType;
 };
 
+// ----------------------------------------------------------------------------
+// Metafunction ReadNames
+// ----------------------------------------------------------------------------
+// Mapped reads files keep the names as infixes of the mapping.
+
+template <typename TInputType, typename TSpec>
+struct ReadNames
+{
+    typedef StringSet<CharString, TSpec>    Type;
+};
+
+template <typename TSpec>
+struct ReadNames<MMap<>, TSpec>
+{
+    typedef StringSet<typename Infix<String<char, MMap<> > const>::Type>    Type;
+};
+
 // ----------------------------------------------------------------------------
 // Class Reads
 // ----------------------------------------------------------------------------
@@ -74,7 +102,8 @@ struct Reads
     typedef typename TConfig::TReadNameSpec             TReadNameSpec;
 
     typedef StringSet<TReadSeq, TReadSpec>              TReadSeqs;
-	typedef StringSet<CharString, TReadNameSpec>        TReadNames;
+	typedef typename ReadNames<typename TConfig::TInputType,
+                               TReadNameSpec>::Type     TReadNames;
 	typedef NameStoreCache<TReadNames, CharString>      TReadNamesCache;
 
     TReadSeqs           seqs;
@@ -98,11 +127,13 @@ struct InputStream
     typedef std::fstream    Type;
 };
 
+#if SEQAN_HAS_ZLIB
 template <>
 struct InputStream<GZFile>
 {
-    typedef Stream<GZFile>  Type;
+    typedef GZInput         Type;
 };
+#endif
 
 #if SEQAN_HAS_BZIP2
 template <>
@@ -112,6 +143,36 @@ struct InputStream<BZ2File>
 };
 #endif
 
+// ----------------------------------------------------------------------------
+// Class ReadsBuffer
+// ----------------------------------------------------------------------------
+// Stores the text of one batch of records and the begin of each record, followed by the end of the last one.
+
+struct ReadsBuffer
+{
+    CharString          text;
+    String<__uint64>    records;
+};
+
+// ----------------------------------------------------------------------------
+// Class ReadsMap
+// ----------------------------------------------------------------------------
+// Maps a plain reads file, the records are located and parsed in place starting from pos.
+
+template <typename TInputType>
+struct ReadsMap {};
+
+template <>
+struct ReadsMap<MMap<> >
+{
+    String<char, MMap<> >   text;
+    __uint64                pos;
+
+    ReadsMap() :
+        pos(0)
+    {}
+};
+
 // ----------------------------------------------------------------------------
 // Class ReadsLoader
 // ----------------------------------------------------------------------------
@@ -122,10 +183,13 @@ struct ReadsLoader
     typedef typename TConfig::TInputType            TInputType;
     typedef typename InputStream<TInputType>::Type  TStream;
     typedef RecordReader<TStream, SinglePass<> >    TRecordReader;
+    typedef ReadsBuffer                             TBuffer;
 
     TStream                         _file;
     AutoSeqStreamFormat             _fileFormat;
     std::auto_ptr<TRecordReader>    _reader;
+    TBuffer                         _buffer;
+    ReadsMap<TInputType>            _map;
 };
 
 // ----------------------------------------------------------------------------
@@ -138,33 +202,61 @@ struct ReadsLoader<PairedEnd, TConfig>
     typedef typename TConfig::TInputType            TInputType;
     typedef typename InputStream<TInputType>::Type  TStream;
     typedef RecordReader<TStream, SinglePass<> >    TRecordReader;
+    typedef Pair<ReadsBuffer>                       TBuffer;
 
     TStream                             _file1;
     TStream                             _file2;
     Pair<AutoSeqStreamFormat>           _fileFormat;
     Pair<std::auto_ptr<TRecordReader> > _reader;
+    TBuffer                             _buffer;
+    Pair<ReadsMap<TInputType> >         _map;
 };
 
 // ----------------------------------------------------------------------------
-// Class LoadReadsWorker
+// Class ReadsRing
 // ----------------------------------------------------------------------------
+// Ring of batches of reads loaded ahead, in input order, by a pool of threads.
+// A batch is read serially from the loader, then parsed concurrently with the other batches.
 
 template <typename TSpec, typename TConfig>
-struct LoadReadsWorker
+struct ReadsRing
 {
-    Reads<TSpec, TConfig> *         reads;
-    ReadsLoader<TSpec, TConfig> &   readsLoader;
-    unsigned                        readsCount;
-
-    LoadReadsWorker(Reads<TSpec, TConfig> * reads, ReadsLoader<TSpec, TConfig> & readsLoader, unsigned readsCount) :
-        reads(reads),
-        readsLoader(readsLoader),
-        readsCount(readsCount)
+    typedef Reads<TSpec, TConfig>                   TReads;
+    typedef ReadsLoader<TSpec, TConfig>             TReadsLoader;
+    typedef typename TReadsLoader::TBuffer          TBuffer;
+
+    TReadsLoader &              loader;
+    std::vector<TReads>         batches;
+    std::vector<TBuffer>        buffers;
+    std::vector<char>           ready;
+    std::vector<std::thread>    threads;
+    std::mutex                  mutex;
+    std::condition_variable     filled;
+    std::condition_variable     emptied;
+    std::exception_ptr          error;
+
+    unsigned                    readsCount;
+    unsigned                    threadsCount;
+    __uint64                    loadBatch;
+    __uint64                    popBatch;
+    __uint64                    freeBatch;
+    bool                        eof;
+    bool                        stop;
+
+    ReadsRing(TReadsLoader & loader) :
+        loader(loader),
+        readsCount(0),
+        threadsCount(1),
+        loadBatch(0),
+        popBatch(0),
+        freeBatch(0),
+        eof(false),
+        stop(false)
     {}
 
-    void operator() ()
+    ~ReadsRing()
     {
-        load(*reads, readsLoader, readsCount);
+        close(*this);
     }
 };
 
@@ -185,6 +277,53 @@ inline bool open(Stream<TSpec> & stream, const char *fileName, int /* mode */)
 }
 }
 
+// ----------------------------------------------------------------------------
+// Function _isBuffered()
+// ----------------------------------------------------------------------------
+// Returns true if the records of this format are buffered and parsed in parallel.
+
+inline bool _isBuffered(AutoSeqStreamFormat const & format)
+{
+    return format.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE ||
+           format.tagId == Find<AutoSeqStreamFormat, Fastq>::VALUE;
+}
+
+// ----------------------------------------------------------------------------
+// Function isMappable()
+// ----------------------------------------------------------------------------
+// Returns true if the plain reads file is in a buffered format, only those files are mapped.
+
+template <typename TString>
+inline bool isMappable(TString const & readsFile)
+{
+    typedef InputStream<Nothing>::Type              TStream;
+    typedef RecordReader<TStream, SinglePass<> >    TRecordReader;
+
+    TStream file;
+    if (!open(file, toCString(readsFile), OPEN_RDONLY))
+        return false;
+
+    TRecordReader reader(file);
+    AutoSeqStreamFormat format;
+    return guessStreamFormat(reader, format) && _isBuffered(format);
+}
+
+// ----------------------------------------------------------------------------
+// Function _openStdin()
+// ----------------------------------------------------------------------------
+// Attaches a plain stream to the buffer of std::cin, compressed streams cannot read the standard input.
+
+template <typename TStream>
+inline void _openStdin(TStream & /* file */)
+{
+    throw RuntimeError("Compressed reads cannot be read from the standard input.");
+}
+
+inline void _openStdin(std::fstream & file)
+{
+    static_cast<std::ios &>(file).rdbuf(std::cin.rdbuf());
+}
+
 // ----------------------------------------------------------------------------
 // Function open()
 // ----------------------------------------------------------------------------
@@ -195,8 +334,10 @@ void open(ReadsLoader<TSpec, TConfig> & me, TString const & readsFile)
     typedef ReadsLoader<TSpec, TConfig>             TReadsLoader;
     typedef typename TReadsLoader::TRecordReader    TRecordReader;
 
-    // Open file.
-    if (!open(me._file, toCString(readsFile), OPEN_RDONLY))
+    // Open file, - stands for the standard input.
+    if (readsFile == "-")
+        _openStdin(me._file);
+    else if (!open(me._file, toCString(readsFile), OPEN_RDONLY))
         throw RuntimeError("Error while opening reads file.");
 
     // Initialize record reader.
@@ -205,6 +346,8 @@ void open(ReadsLoader<TSpec, TConfig> & me, TString const & readsFile)
     // Autodetect file format.
     if (!guessStreamFormat(*(me._reader), me._fileFormat))
         throw RuntimeError("Error while guessing reads file format.");
+
+    _open(me._map, readsFile, me._fileFormat);
 }
 
 template <typename TConfig, typename TString>
@@ -228,6 +371,28 @@ void open(ReadsLoader<PairedEnd, TConfig> & me, Pair<TString> const & readsFile)
     if (!guessStreamFormat(*(me._reader.i1), me._fileFormat.i1) ||
         !guessStreamFormat(*(me._reader.i2), me._fileFormat.i2))
         throw RuntimeError("Error while guessing reads file format.");
+
+    _open(me._map.i1, readsFile.i1, me._fileFormat.i1);
+    _open(me._map.i2, readsFile.i2, me._fileFormat.i2);
+}
+
+// Plain Fasta and Fastq files are mapped, the record reader is only used to guess their format.
+// The other plain files are streamed, see isMappable().
+
+template <typename TInputType, typename TString>
+inline void _open(ReadsMap<TInputType> & /* me */, TString const & /* readsFile */, AutoSeqStreamFormat const & /* format */)
+{}
+
+template <typename TString>
+inline void _open(ReadsMap<MMap<> > & me, TString const & readsFile, AutoSeqStreamFormat const & format)
+{
+    if (!_isBuffered(format))
+        throw RuntimeError("Unsupported reads file format.");
+
+    if (!open(me.text, toCString(readsFile), OPEN_RDONLY))
+        throw RuntimeError("Error while opening reads file.");
+
+    me.pos = 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -238,6 +403,7 @@ template <typename TSpec, typename TConfig>
 void close(ReadsLoader<TSpec, TConfig> & me)
 {
     close(me._file);
+    close(me._map);
 }
 
 template <typename TConfig>
@@ -245,25 +411,139 @@ void close(ReadsLoader<PairedEnd, TConfig> & me)
 {
     close(me._file1);
     close(me._file2);
+    close(me._map.i1);
+    close(me._map.i2);
+}
+
+template <typename TInputType>
+inline void close(ReadsMap<TInputType> & /* me */)
+{}
+
+inline void close(ReadsMap<MMap<> > & me)
+{
+    close(me.text);
 }
 
 // ----------------------------------------------------------------------------
 // Function load()
 // ----------------------------------------------------------------------------
+// Loads the next batch of reads, i.e. reads its records and then parses them.
 
 template <typename TSpec, typename TConfig, typename TSize>
 void load(Reads<TSpec, TConfig> & reads, ReadsLoader<TSpec, TConfig> & me, TSize count)
 {
-    _load(reads, count, *(me._reader), me._fileFormat);
+    readRecords(reads, me._buffer, me, count);
+    parseRecords(reads, me._buffer, me);
+}
+
+// ----------------------------------------------------------------------------
+// Function readRecords()
+// ----------------------------------------------------------------------------
+// Reads the records of the next batch into the buffer, the calls on one loader must be serialized.
+
+template <typename TSpec, typename TConfig, typename TSize>
+void readRecords(Reads<TSpec, TConfig> & reads, ReadsBuffer & buffer, ReadsLoader<TSpec, TConfig> & me, TSize count)
+{
+    _readRecords(reads, buffer, count, me._map, *(me._reader), me._fileFormat);
 }
 
 template <typename TConfig, typename TSize>
-void load(Reads<PairedEnd, TConfig> & reads, ReadsLoader<PairedEnd, TConfig> & me, TSize count)
+void readRecords(Reads<PairedEnd, TConfig> & reads, Pair<ReadsBuffer> & buffer, ReadsLoader<PairedEnd, TConfig> & me,
+                 TSize count)
 {
-    _load(reads, count, *(me._reader.i1), me._fileFormat.i1);
-    _load(reads, count, *(me._reader.i2), me._fileFormat.i2);
+    _readRecords(reads, buffer.i1, count, me._map.i1, *(me._reader.i1), me._fileFormat.i1);
+
+    // The second mates not buffered go straight to the reads, thus the first mates must precede them.
+    if (!_isBuffered(me._fileFormat.i2))
+    {
+        _parseRecords(reads, buffer.i1, me._map.i1, me._fileFormat.i1);
+        clear(buffer.i1.records);
+    }
+
+    _readRecords(reads, buffer.i2, count, me._map.i2, *(me._reader.i2), me._fileFormat.i2);
 }
 
+// Fasta and Fastq records are copied to the buffer, other formats are read and parsed one record at a time.
+
+template <typename TSpec, typename TConfig, typename TSize, typename TInputType, typename TReader>
+inline void _readRecords(Reads<TSpec, TConfig> & reads, ReadsBuffer & buffer, TSize count,
+                         ReadsMap<TInputType> & /* map */, TReader & reader, AutoSeqStreamFormat & format)
+{
+    if (format.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE)
+    {
+        _readRecords(buffer, count, reader, Fasta());
+    }
+    else if (format.tagId == Find<AutoSeqStreamFormat, Fastq>::VALUE)
+    {
+        _readRecords(buffer, count, reader, Fastq());
+    }
+    else
+    {
+        clear(buffer.records);
+        _load(reads, count, reader, format);
+    }
+}
+
+// Mapped records are only located, their text is parsed in place.
+
+template <typename TSpec, typename TConfig, typename TSize, typename TReader>
+inline void _readRecords(Reads<TSpec, TConfig> & /* reads */, ReadsBuffer & buffer, TSize count,
+                         ReadsMap<MMap<> > & map, TReader & /* reader */, AutoSeqStreamFormat & format)
+{
+    if (format.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE)
+        _findRecords(buffer.records, map, count, Fasta());
+    else
+        _findRecords(buffer.records, map, count, Fastq());
+}
+
+// ----------------------------------------------------------------------------
+// Function parseRecords()
+// ----------------------------------------------------------------------------
+// Appends the records in the buffer to the reads, the calls on different buffers can run concurrently.
+
+template <typename TSpec, typename TConfig>
+void parseRecords(Reads<TSpec, TConfig> & reads, ReadsBuffer const & buffer, ReadsLoader<TSpec, TConfig> const & me)
+{
+    _parseRecords(reads, buffer, me._map, me._fileFormat);
+}
+
+template <typename TConfig>
+void parseRecords(Reads<PairedEnd, TConfig> & reads, Pair<ReadsBuffer> const & buffer,
+                  ReadsLoader<PairedEnd, TConfig> const & me)
+{
+    _parseRecords(reads, buffer.i1, me._map.i1, me._fileFormat.i1);
+    _parseRecords(reads, buffer.i2, me._map.i2, me._fileFormat.i2);
+}
+
+// The buffer is empty if its records were already parsed by readRecords().
+
+template <typename TSpec, typename TConfig, typename TInputType>
+inline void _parseRecords(Reads<TSpec, TConfig> & reads, ReadsBuffer const & buffer,
+                          ReadsMap<TInputType> const & /* map */, AutoSeqStreamFormat const & format)
+{
+    if (empty(buffer.records)) return;
+
+    if (format.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE)
+        _parseRecords(reads, buffer.text, buffer.records, Fasta());
+    else
+        _parseRecords(reads, buffer.text, buffer.records, Fastq());
+}
+
+template <typename TSpec, typename TConfig>
+inline void _parseRecords(Reads<TSpec, TConfig> & reads, ReadsBuffer const & buffer,
+                          ReadsMap<MMap<> > const & map, AutoSeqStreamFormat const & format)
+{
+    if (format.tagId == Find<AutoSeqStreamFormat, Fasta>::VALUE)
+        _parseRecords(reads, map.text, buffer.records, Fasta());
+    else
+        _parseRecords(reads, map.text, buffer.records, Fastq());
+}
+
+// ----------------------------------------------------------------------------
+// Function _load()
+// ----------------------------------------------------------------------------
+// Reads and parses one record at a time.
+
 template <typename TSpec, typename TConfig, typename TSize, typename TReader, typename TFormat>
 void _load(Reads<TSpec, TConfig> & reads, TSize count, TReader & reader, TFormat & format)
 {
@@ -284,6 +564,391 @@ void _load(Reads<TSpec, TConfig> & reads, TSize count, TReader & reader, TFormat
     }
 }
 
+// ----------------------------------------------------------------------------
+// Function _copyLine()
+// ----------------------------------------------------------------------------
+// Copies the current line to the buffer and returns its number of non-space characters.
+
+template <typename TReader>
+inline unsigned _copyLine(ReadsBuffer & buffer, TReader & reader)
+{
+    unsigned count = 0;
+
+    for (; !atEnd(reader); goNext(reader))
+    {
+        char c = value(reader);
+        appendValue(buffer.text, c, Generous());
+
+        if (c == '\n')
+        {
+            goNext(reader);
+            break;
+        }
+
+        count += !isspace(static_cast<unsigned char>(c));
+    }
+
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// Function _readRecords()
+// ----------------------------------------------------------------------------
+// Copies the text of the next records to the buffer.
+
+template <typename TSize, typename TReader>
+inline void _readRecords(ReadsBuffer & buffer, TSize count, TReader & reader, Fasta)
+{
+    clear(buffer.text);
+    clear(buffer.records);
+
+    while (!atEnd(reader) && length(buffer.records) < count)
+    {
+        if (isspace(static_cast<unsigned char>(value(reader))))
+        {
+            goNext(reader);
+            continue;
+        }
+
+        if (value(reader) != '>')
+            throw RuntimeError("Error while reading read record.");
+
+        appendValue(buffer.records, length(buffer.text), Generous());
+
+        // Copy the header and the sequence lines.
+        _copyLine(buffer, reader);
+        while (!atEnd(reader) && value(reader) != '>')
+            _copyLine(buffer, reader);
+    }
+
+    if (resultCode(reader) != 0)
+        throw RuntimeError("Error while reading read record.");
+
+    appendValue(buffer.records, length(buffer.text), Generous());
+}
+
+// The qualities are counted to find the end of a record, as a quality line can start with '@'.
+// A record with fewer qualities than bases is truncated, as is a batch interrupted by a reader error.
+
+template <typename TSize, typename TReader>
+inline void _readRecords(ReadsBuffer & buffer, TSize count, TReader & reader, Fastq)
+{
+    clear(buffer.text);
+    clear(buffer.records);
+
+    while (!atEnd(reader) && length(buffer.records) < count)
+    {
+        if (isspace(static_cast<unsigned char>(value(reader))))
+        {
+            goNext(reader);
+            continue;
+        }
+
+        if (value(reader) != '@')
+            throw RuntimeError("Error while reading read record.");
+
+        appendValue(buffer.records, length(buffer.text), Generous());
+
+        // Copy the header and the sequence lines.
+        _copyLine(buffer, reader);
+        __uint64 seqLength = 0;
+        while (!atEnd(reader) && value(reader) != '+')
+            seqLength += _copyLine(buffer, reader);
+
+        // Copy the separator and the quality lines.
+        _copyLine(buffer, reader);
+        __uint64 qualLength = 0;
+        while (!atEnd(reader) && qualLength < seqLength)
+            qualLength += _copyLine(buffer, reader);
+
+        if (qualLength < seqLength)
+            throw RuntimeError("Error while reading read record.");
+    }
+
+    if (resultCode(reader) != 0)
+        throw RuntimeError("Error while reading read record.");
+
+    appendValue(buffer.records, length(buffer.text), Generous());
+}
+
+// ----------------------------------------------------------------------------
+// Function _findRecords()
+// ----------------------------------------------------------------------------
+// Locates the next records in the mapped file, as _readRecords() does on the buffer.
+
+template <typename TIter>
+inline TIter _nextLine(TIter it, TIter itEnd)
+{
+    TIter lineEnd = static_cast<TIter>(std::memchr(it, '\n', itEnd - it));
+    return lineEnd ? lineEnd + 1 : itEnd;
+}
+
+template <typename TSize>
+inline void _findRecords(String<__uint64> & records, ReadsMap<MMap<> > & me, TSize count, Fasta)
+{
+    typedef Iterator<String<char, MMap<> > const, Standard>::Type   TIter;
+
+    TIter textBegin = begin(me.text, Standard());
+    TIter textEnd = end(me.text, Standard());
+    TIter it = textBegin + me.pos;
+
+    clear(records);
+
+    while (it != textEnd && length(records) < count)
+    {
+        if (isspace(static_cast<unsigned char>(*it)))
+        {
+            ++it;
+            continue;
+        }
+
+        if (*it != '>')
+            throw RuntimeError("Error while reading read record.");
+
+        appendValue(records, it - textBegin, Generous());
+
+        // Skip the header and the sequence lines.
+        it = _nextLine(it, textEnd);
+        while (it != textEnd && *it != '>')
+            it = _nextLine(it, textEnd);
+    }
+
+    appendValue(records, it - textBegin, Generous());
+    me.pos = it - textBegin;
+}
+
+template <typename TSize>
+inline void _findRecords(String<__uint64> & records, ReadsMap<MMap<> > & me, TSize count, Fastq)
+{
+    typedef Iterator<String<char, MMap<> > const, Standard>::Type   TIter;
+
+    TIter textBegin = begin(me.text, Standard());
+    TIter textEnd = end(me.text, Standard());
+    TIter it = textBegin + me.pos;
+
+    clear(records);
+
+    while (it != textEnd && length(records) < count)
+    {
+        if (isspace(static_cast<unsigned char>(*it)))
+        {
+            ++it;
+            continue;
+        }
+
+        if (*it != '@')
+            throw RuntimeError("Error while reading read record.");
+
+        appendValue(records, it - textBegin, Generous());
+
+        // Skip the header and the sequence lines.
+        it = _nextLine(it, textEnd);
+        __uint64 seqLength = 0;
+        while (it != textEnd && *it != '+')
+        {
+            TIter lineEnd = _nextLine(it, textEnd);
+            for (; it != lineEnd; ++it)
+                seqLength += !isspace(static_cast<unsigned char>(*it));
+        }
+
+        // Skip the separator and the quality lines.
+        it = _nextLine(it, textEnd);
+        __uint64 qualLength = 0;
+        while (it != textEnd && qualLength < seqLength)
+        {
+            TIter lineEnd = _nextLine(it, textEnd);
+            for (; it != lineEnd; ++it)
+                qualLength += !isspace(static_cast<unsigned char>(*it));
+        }
+
+        if (qualLength < seqLength)
+            throw RuntimeError("Error while reading read record.");
+    }
+
+    appendValue(records, it - textBegin, Generous());
+    me.pos = it - textBegin;
+}
+
+// ----------------------------------------------------------------------------
+// Function _locateRecord()
+// ----------------------------------------------------------------------------
+// Locates the name, the sequence lines and the quality lines of one record.
+// The name is cut at the last space of the header, as the serial loader does.
+
+template <typename TIter>
+inline void _locateHeader(Pair<TIter> & name, TIter & headerEnd, TIter recordBegin, TIter recordEnd)
+{
+    headerEnd = std::find(recordBegin, recordEnd, '\n');
+
+    name.i1 = recordBegin + 1;
+    name.i2 = headerEnd;
+    for (; name.i2 != name.i1 && isspace(static_cast<unsigned char>(*(name.i2 - 1))); --name.i2) ;
+
+    for (TIter it = name.i2; it != name.i1; )
+    {
+        if (isspace(static_cast<unsigned char>(*(--it))))
+        {
+            name.i2 = it;
+            break;
+        }
+    }
+
+    if (headerEnd != recordEnd) ++headerEnd;
+}
+
+template <typename TIter>
+inline void _locateRecord(Pair<TIter> & name, Pair<TIter> & seq, Pair<TIter> & qual,
+                          TIter recordBegin, TIter recordEnd, Fasta)
+{
+    _locateHeader(name, seq.i1, recordBegin, recordEnd);
+    seq.i2 = recordEnd;
+    qual = Pair<TIter>(recordEnd, recordEnd);
+}
+
+template <typename TIter>
+inline void _locateRecord(Pair<TIter> & name, Pair<TIter> & seq, Pair<TIter> & qual,
+                          TIter recordBegin, TIter recordEnd, Fastq)
+{
+    _locateHeader(name, seq.i1, recordBegin, recordEnd);
+
+    // The sequence lines end at the separator line.
+    for (seq.i2 = seq.i1; seq.i2 != recordEnd && *seq.i2 != '+'; )
+    {
+        seq.i2 = std::find(seq.i2, recordEnd, '\n');
+        if (seq.i2 != recordEnd) ++seq.i2;
+    }
+
+    qual.i1 = std::find(seq.i2, recordEnd, '\n');
+    if (qual.i1 != recordEnd) ++qual.i1;
+    qual.i2 = recordEnd;
+}
+
+// ----------------------------------------------------------------------------
+// Function _packRecord()
+// ----------------------------------------------------------------------------
+// Packs the sequence and the Phred+33 qualities, if any, of one record.
+
+template <typename TTargetIt, typename TIter>
+inline void _packRecord(TTargetIt target, Pair<TIter> seq, Pair<TIter> qual)
+{
+    typedef typename Value<TTargetIt>::Type TAlphabet;
+
+    for (TIter it = seq.i1; it != seq.i2; ++it)
+    {
+        if (isspace(static_cast<unsigned char>(*it))) continue;
+
+        *target = TAlphabet(*it);
+
+        for (; qual.i1 != qual.i2 && isspace(static_cast<unsigned char>(*qual.i1)); ++qual.i1) ;
+        if (qual.i1 != qual.i2)
+            assignQualityValue(*target, *(qual.i1++) - 33);
+
+        ++target;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendNames()
+// ----------------------------------------------------------------------------
+// Appends the names given by their begin in the text and their length.
+
+template <typename TSpec, typename TText>
+inline void _appendNames(StringSet<CharString, Owner<ConcatDirect<TSpec> > > & names, TText const & text,
+                         String<__uint64> const & namesBegin, String<__uint64> & namesLimits)
+{
+    __int64 namesCount = length(namesBegin);
+
+    namesLimits[0] = lengthSum(names);
+    partialSum(namesLimits);
+
+    resize(concat(names), back(namesLimits), Generous());
+    for (__int64 nameId = 0; nameId < namesCount; ++nameId)
+        appendValue(stringSetLimits(names), namesLimits[nameId + 1], Generous());
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(static))
+    for (__int64 nameId = 0; nameId < namesCount; ++nameId)
+        std::copy(begin(text, Standard()) + namesBegin[nameId],
+                  begin(text, Standard()) + namesBegin[nameId] + (namesLimits[nameId + 1] - namesLimits[nameId]),
+                  begin(concat(names), Standard()) + namesLimits[nameId]);
+}
+
+// Names stored as infixes are not copied.
+
+template <typename TName, typename TText>
+inline void _appendNames(StringSet<TName> & names, TText const & text,
+                         String<__uint64> const & namesBegin, String<__uint64> const & namesLimits)
+{
+    __int64 namesCount = length(namesBegin);
+
+    reserve(names, length(names) + namesCount, Generous());
+    for (__int64 nameId = 0; nameId < namesCount; ++nameId)
+        appendValue(names, infix(text, namesBegin[nameId], namesBegin[nameId] + namesLimits[nameId + 1]));
+}
+
+// ----------------------------------------------------------------------------
+// Function _parseRecords()
+// ----------------------------------------------------------------------------
+// Appends the records located in the text to the reads, the records are measured and then packed in parallel.
+
+template <typename TSpec, typename TConfig, typename TText, typename TFormat>
+inline void _parseRecords(Reads<TSpec, TConfig> & reads, TText const & text, String<__uint64> const & records,
+                          TFormat const & format)
+{
+    typedef Reads<TSpec, TConfig>                               TReads;
+    typedef typename TReads::TReadSeqs                          TReadSeqs;
+    typedef typename Concatenator<TReadSeqs>::Type              TReadSeqsConcat;
+    typedef typename Iterator<TReadSeqsConcat, Standard>::Type  TReadSeqsIt;
+    typedef typename Iterator<TText const, Standard>::Type      TIter;
+
+    __int64 recordsCount = length(records) - 1;
+    TIter textBegin = begin(text, Standard());
+
+    // Measure the sequence and locate the name of each record.
+    String<__uint64> seqsLimits;
+    String<__uint64> namesBegin;
+    String<__uint64> namesLimits;
+    resize(seqsLimits, recordsCount + 1, 0, Exact());
+    resize(namesBegin, recordsCount, 0, Exact());
+    resize(namesLimits, recordsCount + 1, 0, Exact());
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(static))
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        Pair<TIter> name, seq, qual;
+        _locateRecord(name, seq, qual, textBegin + records[recordId], textBegin + records[recordId + 1], format);
+
+        __uint64 seqLength = 0;
+        for (TIter it = seq.i1; it != seq.i2; ++it)
+            seqLength += !isspace(static_cast<unsigned char>(*it));
+
+        seqsLimits[recordId + 1] = seqLength;
+        namesBegin[recordId] = name.i1 - textBegin;
+        namesLimits[recordId + 1] = name.i2 - name.i1;
+    }
+
+    // Append the records after the reads loaded so far.
+    seqsLimits[0] = lengthSum(reads.seqs);
+    partialSum(seqsLimits);
+
+    resize(concat(reads.seqs), back(seqsLimits), Generous());
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+        appendValue(stringSetLimits(reads.seqs), seqsLimits[recordId + 1], Generous());
+
+    _appendNames(reads.names, text, namesBegin, namesLimits);
+
+    // Pack the records.
+    TReadSeqsIt seqsBegin = begin(concat(reads.seqs), Standard());
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(static))
+    for (__int64 recordId = 0; recordId < recordsCount; ++recordId)
+    {
+        Pair<TIter> name, seq, qual;
+        _locateRecord(name, seq, qual, textBegin + records[recordId], textBegin + records[recordId + 1], format);
+
+        _packRecord(seqsBegin + seqsLimits[recordId], seq, qual);
+    }
+}
+
 // ----------------------------------------------------------------------------
 // Function atEnd()
 // ----------------------------------------------------------------------------
@@ -291,13 +956,159 @@ void _load(Reads<TSpec, TConfig> & reads, TSize count, TReader & reader, TFormat
 template <typename TSpec, typename TConfig>
 inline bool atEnd(ReadsLoader<TSpec, TConfig> & reads)
 {
-    return atEnd(*(reads._reader));
+    return _atEnd(reads._map, *(reads._reader));
 }
 
 template <typename TConfig>
 inline bool atEnd(ReadsLoader<PairedEnd, TConfig> & reads)
 {
-    return atEnd(*(reads._reader.i1)) && atEnd(*(reads._reader.i2));
+    return _atEnd(reads._map.i1, *(reads._reader.i1)) && _atEnd(reads._map.i2, *(reads._reader.i2));
+}
+
+template <typename TInputType, typename TReader>
+inline bool _atEnd(ReadsMap<TInputType> & /* me */, TReader & reader)
+{
+    return atEnd(reader);
+}
+
+template <typename TReader>
+inline bool _atEnd(ReadsMap<MMap<> > & me, TReader & /* reader */)
+{
+    return me.pos == length(me.text);
+}
+
+// ----------------------------------------------------------------------------
+// Function _loadBatches()
+// ----------------------------------------------------------------------------
+// Loads the next batches into the free slots of the ring until the end of the input.
+
+template <typename TSpec, typename TConfig>
+inline void _loadBatches(ReadsRing<TSpec, TConfig> & me)
+{
+    omp_set_num_threads(me.threadsCount);
+
+    while (true)
+    {
+        __uint64 slot;
+        bool failed = false;
+
+        {
+            std::unique_lock<std::mutex> lock(me.mutex);
+
+            me.emptied.wait(lock, [&me] { return me.stop || me.eof || me.loadBatch < me.freeBatch + me.batches.size(); });
+
+            if (me.stop || me.eof) return;
+
+            slot = me.loadBatch++ % me.batches.size();
+
+            // Read the records in input order.
+            try
+            {
+                readRecords(me.batches[slot], me.buffers[slot], me.loader, me.readsCount);
+                me.eof = atEnd(me.loader);
+            }
+            catch (...)
+            {
+                me.error = std::current_exception();
+                me.eof = failed = true;
+            }
+        }
+        me.emptied.notify_all();
+
+        // Parse the records concurrently with the other loaders.
+        try
+        {
+            if (!failed)
+                parseRecords(me.batches[slot], me.buffers[slot], me.loader);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(me.mutex);
+            me.error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(me.mutex);
+            me.ready[slot] = true;
+        }
+        me.filled.notify_all();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function start()
+// ----------------------------------------------------------------------------
+// Starts loading batches of readsCount reads into a ring of batchesCount batches on loadersCount threads.
+// Without loader threads, the batches are loaded on demand by pop().
+
+template <typename TSpec, typename TConfig, typename TSize>
+inline void start(ReadsRing<TSpec, TConfig> & me, TSize readsCount, unsigned batchesCount, unsigned loadersCount)
+{
+    me.readsCount = readsCount;
+    me.batches.resize(batchesCount);
+    me.buffers.resize(batchesCount);
+    me.ready.assign(batchesCount, false);
+
+    // The loaders share the OpenMP threads to parse their batches.
+    me.threadsCount = std::max(omp_get_max_threads() / static_cast<int>(std::max(loadersCount, 1u)), 1);
+
+    for (unsigned loaderId = 0; loaderId < loadersCount; ++loaderId)
+        me.threads.push_back(std::thread(_loadBatches<TSpec, TConfig>, std::ref(me)));
+}
+
+// ----------------------------------------------------------------------------
+// Function pop()
+// ----------------------------------------------------------------------------
+// Returns the next batch of reads and gives the previous one back to the ring.
+// The batch returned at the end of the input is empty.
+
+template <typename TSpec, typename TConfig>
+inline typename ReadsRing<TSpec, TConfig>::TReads &
+pop(ReadsRing<TSpec, TConfig> & me)
+{
+    std::unique_lock<std::mutex> lock(me.mutex);
+
+    if (me.freeBatch < me.popBatch)
+    {
+        __uint64 freeSlot = me.freeBatch++ % me.batches.size();
+        clear(me.batches[freeSlot]);
+        me.ready[freeSlot] = false;
+        me.emptied.notify_all();
+    }
+
+    __uint64 slot = me.popBatch++ % me.batches.size();
+
+    if (me.threads.empty())
+    {
+        load(me.batches[slot], me.loader, me.readsCount);
+    }
+    else
+    {
+        me.filled.wait(lock, [&me, slot] { return me.error || me.ready[slot] || (me.eof && me.popBatch > me.loadBatch); });
+
+        if (me.error)
+            std::rethrow_exception(me.error);
+    }
+
+    return me.batches[slot];
+}
+
+// ----------------------------------------------------------------------------
+// Function close()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec, typename TConfig>
+inline void close(ReadsRing<TSpec, TConfig> & me)
+{
+    {
+        std::lock_guard<std::mutex> lock(me.mutex);
+        me.stop = true;
+    }
+    me.emptied.notify_all();
+
+    for (unsigned threadId = 0; threadId < me.threads.size(); ++threadId)
+        me.threads[threadId].join();
+    me.threads.clear();
 }
 
 // ----------------------------------------------------------------------------
@@ -429,6 +1240,14 @@ getReadId(TReadSeqs const & readSeqs, TReadSeqId readSeqId)
     return isFwdReadSeq(readSeqs, readSeqId) ? readSeqId : readSeqId - getReadsCount(readSeqs);
 }
 
+template <typename TReadSeqs, typename TReadSeqId>
+inline typename Size<TReadSeqs>::Type
+getRevSeqId(TReadSeqs const & readSeqs, TReadSeqId readSeqId)
+{
+    SEQAN_ASSERT(isFwdReadSeq(readSeqs, readSeqId));
+    return readSeqId + getReadsCount(readSeqs);
+}
+
 template <typename TReadSeqs, typename TReadSeqId>
 inline typename Size<TReadSeqs>::Type
 getPairId(TReadSeqs const & readSeqs, TReadSeqId readSeqId)
@@ -0,0 +1,279 @@
+#!/usr/bin/env python
+"""Benchmark the yara indexer on synthetic reference genomes.
+
+The script generates random references of the given lengths, contig counts and
+repeat contents, indexes each one with yara_indexer and prints one JSON record
+per run. Each record holds the wall time of every stage reported by the
+indexer, the total wall time, the peak resident memory of the indexer, the
+peak usage of its temporary folder and the size of the index files.
+
+Usage:  benchmark_indexer.py --indexer PATH [options] [-- INDEXER ARGS]
+
+Example:
+
+  benchmark_indexer.py --indexer bin/yara_indexer --lengths 10M,100M \\
+                       --contigs 1,1000 --repeats 0,0.5 -- --threads 8
+"""
+from __future__ import print_function
+
+import argparse
+import binascii
+import json
+import os
+import os.path
+import random
+import re
+import shutil
+import sys
+import time
+
+# Line width of the generated Fasta files.
+FASTA_LINE = 80
+
+# Length of the random blocks drawn at once.
+BLOCK_LENGTH = 1 << 20
+
+# Stage timings printed by the indexer in verbose mode, e.g. "Loading reference:    0.53 sec".
+STAGE_REGEX = re.compile(r'^(?P<stage>[^:\t]+):\s+(?P<time>[0-9.eE+\-]+) sec\s*$')
+
+# Seconds between two samples of the temporary folder.
+POLL_INTERVAL = 0.1
+
+try:
+    BASES = bytes.maketrans(bytes(bytearray(range(256))), b'ACGT' * 64)
+except AttributeError:
+    import string
+    BASES = string.maketrans(''.join(map(chr, range(256))), 'ACGT' * 64)
+
+
+# ============================================================
+# Synthetic references.
+# ============================================================
+
+def parseLength(value):
+    """Parses a length with an optional K, M or G suffix."""
+    suffixes = {'K': 10 ** 3, 'M': 10 ** 6, 'G': 10 ** 9}
+    value = value.strip().upper()
+    if value and value[-1] in suffixes:
+        return int(float(value[:-1]) * suffixes[value[-1]])
+    return int(value)
+
+
+def randomBytes(rng, count):
+    """Returns count pseudo-random bytes drawn from rng."""
+    bits = rng.getrandbits(8 * count)
+    if hasattr(bits, 'to_bytes'):
+        return bits.to_bytes(count, 'little')
+    return binascii.unhexlify('%0*x' % (2 * count, bits))
+
+
+def randomDna(rng, length):
+    """Returns a random DNA sequence of the given length."""
+    seq = bytearray()
+    while len(seq) < length:
+        seq += randomBytes(rng, min(BLOCK_LENGTH, length - len(seq))).translate(BASES)
+    return seq
+
+
+def mutate(rng, seq, rate):
+    """Substitutes a fraction rate of the bases of seq."""
+    seq = bytearray(seq)
+    for _ in range(int(len(seq) * rate)):
+        seq[rng.randrange(len(seq))] = ord(rng.choice('ACGT'))
+    return seq
+
+
+def generateGenome(fileName, length, contigs, repeats, repeatLength, repeatFamilies, divergence, seed):
+    """Writes a random reference to fileName and returns its number of contigs.
+
+    A fraction repeats of the reference is covered by diverged copies of
+    repeatFamilies random elements of repeatLength bases.
+    """
+    rng = random.Random(seed)
+
+    genome = randomDna(rng, length)
+
+    families = [randomDna(rng, repeatLength) for _ in range(repeatFamilies)]
+    for _ in range(int(length * repeats) // repeatLength if families and repeatLength <= length else 0):
+        pos = rng.randrange(length - repeatLength + 1)
+        genome[pos:pos + repeatLength] = mutate(rng, rng.choice(families), divergence)
+
+    # Cut the reference at distinct random positions.
+    cuts = sorted(set(rng.randrange(1, length) for _ in range(min(contigs, length) - 1)))
+    limits = [0] + cuts + [length]
+
+    with open(fileName, 'wb') as fasta:
+        for contigId in range(len(limits) - 1):
+            fasta.write(('>contig_%d\n' % contigId).encode('ascii'))
+            for pos in range(limits[contigId], limits[contigId + 1], FASTA_LINE):
+                fasta.write(genome[pos:min(pos + FASTA_LINE, limits[contigId + 1])])
+                fasta.write(b'\n')
+
+    return len(limits) - 1
+
+
+# ============================================================
+# Indexer runs.
+# ============================================================
+
+def folderSize(path):
+    """Returns the size in bytes of the files below path."""
+    size = 0
+    for root, _, files in os.walk(path):
+        for name in files:
+            try:
+                size += os.path.getsize(os.path.join(root, name))
+            except OSError:
+                pass
+    return size
+
+
+def runIndexer(indexer, genomeFile, indexPrefix, tmpFolder, logFile, args):
+    """Runs the indexer and returns its exit status, wall time, peak RSS and peak temporary disk usage."""
+    if os.path.exists(tmpFolder):
+        shutil.rmtree(tmpFolder)
+    os.makedirs(tmpFolder)
+
+    command = [indexer, genomeFile, '-xp', indexPrefix, '--tmp-folder', tmpFolder, '-v'] + args
+
+    with open(logFile, 'w') as log:
+        start = time.time()
+        pid = _spawn(command, log)
+        tmpPeak = 0
+        while True:
+            tmpPeak = max(tmpPeak, folderSize(tmpFolder))
+            waited, status, usage = os.wait4(pid, os.WNOHANG)
+            if waited == pid:
+                break
+            time.sleep(POLL_INTERVAL)
+        wallTime = time.time() - start
+
+    # ru_maxrss is in kilobytes on Linux but in bytes on Mac OS.
+    peakRss = usage.ru_maxrss * (1 if sys.platform == 'darwin' else 1024)
+
+    shutil.rmtree(tmpFolder, ignore_errors=True)
+
+    return os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1, wallTime, peakRss, tmpPeak
+
+
+def _spawn(command, log):
+    """Starts command with its standard output and error redirected to log, returns its pid."""
+    pid = os.fork()
+    if pid == 0:
+        try:
+            os.dup2(log.fileno(), 1)
+            os.dup2(log.fileno(), 2)
+            os.execv(command[0], command)
+        finally:
+            os._exit(127)
+    return pid
+
+
+def parseStages(logFile):
+    """Returns the wall time of each stage in the indexer log, summed over the shards."""
+    stages = {}
+    with open(logFile) as log:
+        for line in log:
+            match = STAGE_REGEX.match(line)
+            if match:
+                stage = match.group('stage').strip()
+                stages[stage] = stages.get(stage, 0.0) + float(match.group('time'))
+    return stages
+
+
+def indexSize(indexPrefix):
+    """Returns the size in bytes of the files written by the indexer."""
+    folder = os.path.dirname(indexPrefix)
+    prefix = os.path.basename(indexPrefix) + '.'
+    return sum(os.path.getsize(os.path.join(folder, fileName))
+               for fileName in os.listdir(folder) if fileName.startswith(prefix))
+
+
+# ============================================================
+# Main.
+# ============================================================
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark yara_indexer on synthetic references.')
+    parser.add_argument('--indexer', required=True, help='path to the yara_indexer binary')
+    parser.add_argument('--work-dir', default='benchmark', help='folder of the references and indices')
+    parser.add_argument('--lengths', default='10M', help='comma-separated reference lengths, e.g. 10M,1G')
+    parser.add_argument('--contigs', default='1', help='comma-separated numbers of contigs')
+    parser.add_argument('--repeats', default='0', help='comma-separated fractions of the reference covered by repeats')
+    parser.add_argument('--repeat-length', type=int, default=300, help='length of the repeat elements')
+    parser.add_argument('--repeat-families', type=int, default=50, help='number of distinct repeat elements')
+    parser.add_argument('--divergence', type=float, default=0.02, help='fraction of substituted bases per repeat copy')
+    parser.add_argument('--runs', type=int, default=1, help='number of runs per reference')
+    parser.add_argument('--seed', type=int, default=0, help='seed of the random references')
+    parser.add_argument('--output', help='append the JSON records to this file')
+    parser.add_argument('--keep', action='store_true', help='keep the references and indices')
+    parser.add_argument('args', nargs=argparse.REMAINDER, help='arguments passed to the indexer after --')
+    options = parser.parse_args()
+
+    indexer = os.path.abspath(options.indexer)
+    indexerArgs = options.args[1:] if options.args[:1] == ['--'] else options.args
+
+    if not os.path.exists(options.work_dir):
+        os.makedirs(options.work_dir)
+
+    output = open(options.output, 'a') if options.output else None
+    failures = 0
+
+    for length in map(parseLength, options.lengths.split(',')):
+        for contigs in map(int, options.contigs.split(',')):
+            for repeats in map(float, options.repeats.split(',')):
+                genomeFolder = os.path.join(options.work_dir, 'genome.%d.%d.%g' % (length, contigs, repeats))
+                genomeFile = os.path.join(genomeFolder, 'genome.fasta')
+                indexPrefix = os.path.join(genomeFolder, 'index')
+                logFile = os.path.join(genomeFolder, 'indexer.log')
+
+                if not os.path.exists(genomeFolder):
+                    os.makedirs(genomeFolder)
+
+                print('Generating %s' % genomeFile, file=sys.stderr)
+                generateStart = time.time()
+                contigsCount = generateGenome(genomeFile, length, contigs, repeats, options.repeat_length,
+                                              options.repeat_families, options.divergence, options.seed)
+                generateTime = time.time() - generateStart
+
+                for run in range(options.runs):
+                    print('Indexing %s, run %d' % (genomeFile, run + 1), file=sys.stderr)
+
+                    status, wallTime, peakRss, tmpPeak = runIndexer(indexer, genomeFile, indexPrefix,
+                                                                    os.path.join(options.work_dir, 'tmp'),
+                                                                    logFile, indexerArgs)
+                    failures += status != 0
+
+                    record = {
+                        'length': length,
+                        'contigs': contigsCount,
+                        'repeats': repeats,
+                        'seed': options.seed,
+                        'run': run + 1,
+                        'args': indexerArgs,
+                        'status': status,
+                        'generate_time': generateTime,
+                        'wall_time': wallTime,
+                        'stages': parseStages(logFile),
+                        'peak_rss': peakRss,
+                        'peak_tmp_disk': tmpPeak,
+                        'index_size': indexSize(indexPrefix)
+                    }
+
+                    line = json.dumps(record, sort_keys=True)
+                    print(line)
+                    if output:
+                        print(line, file=output)
+                        output.flush()
+
+                if not options.keep:
+                    shutil.rmtree(genomeFolder)
+
+    if output:
+        output.close()
+
+    return failures != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,226 @@
+// ==========================================================================
+//                      Yara - Yet Another Read Aligner
+// ==========================================================================
+// Copyright (c) 2011-2014, Enrico Siragusa, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Enrico Siragusa or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ENRICO SIRAGUSA OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Enrico Siragusa <enrico.siragusa@fu-berlin.de>
+// ==========================================================================
+// This file tests the search schemes against backtracking on a small text.
+// ==========================================================================
+
+#define YARA_INDEXER
+
+// ============================================================================
+// Forwards
+// ============================================================================
+
+struct Options;
+
+// ============================================================================
+// Prerequisites
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// STL headers
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// SeqAn headers
+// ----------------------------------------------------------------------------
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/index.h>
+#include <seqan/random.h>
+
+// ----------------------------------------------------------------------------
+// App headers
+// ----------------------------------------------------------------------------
+
+#include "../misc_types.h"
+#include "../index_rank.h"
+#include "../index_fm.h"
+#include "../find_schemes.h"
+
+using namespace seqan;
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class TestHit
+// ----------------------------------------------------------------------------
+
+struct TestHit
+{
+    unsigned    seedId;
+    __uint64    rangeBegin;
+    __uint64    rangeEnd;
+    unsigned    errors;
+
+    bool operator< (TestHit const & other) const
+    {
+        if (seedId != other.seedId) return seedId < other.seedId;
+        if (rangeBegin != other.rangeBegin) return rangeBegin < other.rangeBegin;
+        if (rangeEnd != other.rangeEnd) return rangeEnd < other.rangeEnd;
+        return errors < other.errors;
+    }
+
+    bool operator== (TestHit const & other) const
+    {
+        return seedId == other.seedId && rangeBegin == other.rangeBegin &&
+               rangeEnd == other.rangeEnd && errors == other.errors;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class TestDelegate
+// ----------------------------------------------------------------------------
+
+struct TestDelegate
+{
+    std::vector<TestHit> & hits;
+
+    TestDelegate(std::vector<TestHit> & hits) :
+        hits(hits)
+    {}
+
+    template <typename TIndexIt, typename TSeedsIt>
+    void operator() (TIndexIt const & indexIt, TSeedsIt const & seedsIt, unsigned char errors)
+    {
+        TestHit hit = { (unsigned)position(seedsIt), getValueI1(range(indexIt)), getValueI2(range(indexIt)), errors };
+        hits.push_back(hit);
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _testFindSchemes()
+// ----------------------------------------------------------------------------
+// Checks that the schemes report the same ranges as backtracking, each of them once.
+
+inline void _testFindSchemes(unsigned errors)
+{
+    typedef Index<YaraContigsFM, YaraIndexSpec>     TIndex;
+    typedef Fibre<TIndex, FibreLF>::Type            TRevLF;
+    typedef StringSet<DnaString>                    TSeeds;
+
+    Rng<MersenneTwister> rng(42);
+
+    // Generate two contigs with a few planted copies of the same infix.
+    YaraContigsFM contigs;
+    for (unsigned contigId = 0; contigId < 2; ++contigId)
+    {
+        DnaString contig;
+        for (unsigned i = 0; i < 300; ++i)
+            appendValue(contig, Dna(pickRandomNumber(rng) % 4));
+        appendValue(contigs, contig);
+    }
+    for (unsigned i = 0; i < 40; ++i)
+    {
+        assignValue(contigs[1], 100 + i, contigs[0][50 + i]);
+        assignValue(contigs[1], 200 + i, contigs[0][50 + i]);
+    }
+
+    // Generate seeds from the contigs with random substitutions.
+    TSeeds seeds;
+    for (unsigned seedId = 0; seedId < 200; ++seedId)
+    {
+        unsigned contigId = pickRandomNumber(rng) % 2;
+        unsigned seedBegin = pickRandomNumber(rng) % (300 - 24);
+        DnaString seed = infix(contigs[contigId], seedBegin, seedBegin + 24);
+
+        unsigned substitutions = pickRandomNumber(rng) % (errors + 2);
+        for (unsigned i = 0; i < substitutions; ++i)
+            assignValue(seed, pickRandomNumber(rng) % length(seed), Dna(pickRandomNumber(rng) % 4));
+        appendValue(seeds, seed);
+    }
+
+    // The index is built on the reversed contigs, the reverse LF on the forward contigs.
+    TIndex revIndex(contigs);
+    indexCreate(revIndex, FibreSALF(), Serial());
+    TRevLF revLF = indexLF(revIndex);
+
+    YaraContigsFM reversedContigs = contigs;
+    for (unsigned contigId = 0; contigId < length(reversedContigs); ++contigId)
+        reverse(reversedContigs[contigId]);
+    TIndex index(reversedContigs);
+    indexCreate(index, FibreSALF(), Serial());
+
+    std::vector<TestHit> schemesHits;
+    TestDelegate schemesDelegate(schemesHits);
+    find(index, revLF, seeds, errors, schemesDelegate, SearchSchemes(), Serial());
+
+    std::vector<TestHit> backtrackingHits;
+    TestDelegate backtrackingDelegate(backtrackingHits);
+    find(index, seeds, errors, backtrackingDelegate, Backtracking<HammingDistance>(), Serial());
+
+    std::sort(schemesHits.begin(), schemesHits.end());
+    std::sort(backtrackingHits.begin(), backtrackingHits.end());
+
+    SEQAN_ASSERT_NOT(backtrackingHits.empty());
+    SEQAN_ASSERT_EQ(schemesHits.size(), backtrackingHits.size());
+    SEQAN_ASSERT(schemesHits == backtrackingHits);
+}
+
+// ----------------------------------------------------------------------------
+// Test test_yara_find_schemes_1()
+// ----------------------------------------------------------------------------
+
+SEQAN_DEFINE_TEST(test_yara_find_schemes_1)
+{
+    _testFindSchemes(1);
+}
+
+// ----------------------------------------------------------------------------
+// Test test_yara_find_schemes_2()
+// ----------------------------------------------------------------------------
+
+SEQAN_DEFINE_TEST(test_yara_find_schemes_2)
+{
+    _testFindSchemes(2);
+}
+
+// ============================================================================
+// Register Tests
+// ============================================================================
+
+SEQAN_BEGIN_TESTSUITE(test_find_schemes)
+{
+    SEQAN_CALL_TEST(test_yara_find_schemes_1);
+    SEQAN_CALL_TEST(test_yara_find_schemes_2);
+}
+SEQAN_END_TESTSUITE